@@ -17,6 +17,7 @@
 #ifndef METANG_ALLOC_H
 #define METANG_ALLOC_H
 
+#include "libmetang.h"
 #include "meta.h"
 
 #include <setjmp.h>
@@ -32,17 +33,50 @@
 #define A_F_SOFT_FAIL (1 << 1)
 #define A_F_EXTEND    (1 << 2)
 
-typedef struct arena {
-    char *mem;   // Internal memory block
-    usize cap;   // Total memory capacity of the block
-    usize ofs;   // Current "head" offset in the block
-    jmp_buf env; // Jump buffer to be set by a calling client; refer to `alloc` for details
-} arena;
-
-arena arena_new(usize cap);
+// The arena type, `arena_new`, and `arena_free` are part of the library's
+// interface; see libmetang.h. Where possible, an arena reserves a range of
+// address space up front and commits pages from it as allocations advance, so
+// its memory never moves until the range is spent; then `A_F_EXTEND` chains on
+// another reservation. Otherwise, its first block is taken from the heap.
 
+// Create an arena over the caller-owned buffer `mem`. Any blocks chained on to
+// it by `A_F_EXTEND` are owned by the arena; release them with `arena_free`.
 arena arena_from(char *mem, usize cap);
 
+// A snapshot of an arena's allocation state; see `checkpoint`.
+typedef struct arena_mark {
+    char *mem;
+    usize cap;
+    usize ofs;
+    arena_block *chain;
+} arena_mark;
+
+// A scope of temporary allocations borrowed from a parent arena; see
+// `scratch_begin`.
+typedef struct scratch {
+    arena *a;
+    arena_mark mark;
+    jmp_buf env;
+} scratch;
+
+// Take a snapshot of the allocation state of the arena `a`.
+arena_mark checkpoint(arena *a);
+
+// Discard every allocation made from the arena `a` since `mark` was taken by
+// `checkpoint`, releasing any blocks chained on to `a` since then. Marks must
+// be rolled back in the reverse order in which they were taken.
+void rollback(arena *a, arena_mark mark);
+
+// Begin a scratch scope `s` over the arena `a`. The scope saves `a->env`, so
+// that the client may set its own jump buffer for failures within the scope.
+// Scopes may be nested, so long as they end in the reverse order in which
+// they began.
+void scratch_begin(scratch *s, arena *a);
+
+// End the scratch scope `s`, discarding every allocation made within it and
+// restoring the jump buffer of its arena.
+void scratch_end(scratch *s);
+
 // Expose the next offset at which internal memory will be allocated.
 usize nextofs(arena *a, usize align);
 
@@ -53,8 +87,10 @@ usize nextofs(arena *a, usize align);
 // Flags specified control the internal behavior:
 //   - `A_F_ZERO`      -> The requested memory will be zeroed on return.
 //   - `A_F_SOFT_FAIL` -> If allocation fails, then return `NULL` and do not jump.
-//   - `A_F_EXTEND`    -> If allocation fails, first attempt to reallocate the
-//                        underlying buffer. If successful, proceed as normal.
+//   - `A_F_EXTEND`    -> If allocation fails, first attempt to chain a new
+//                        block on to the arena. If successful, proceed as
+//                        normal. Earlier blocks are never moved, so addresses
+//                        returned by previous allocations remain valid.
 void *alloc(arena *a, usize size, usize align, usize n, int flags);
 
 // Claim a block of memory `buf` with size `len` as part of arena `a`. Return
@@ -65,9 +101,9 @@ void *alloc(arena *a, usize size, usize align, usize n, int flags);
 // claim `buf`, then return `NULL` rather than executing the long jump.
 //
 // If `A_F_EXTEND` is specified and `a` has insufficient available memory to
-// claim `buf`, then this routine will attempt to reallocate `a`'s available
-// memory space to fit. If this reallocation fails, then the failure strategy
-// defers to the existence of `A_F_SOFT_FAIL`.
+// claim `buf`, then this routine will attempt to chain a new block on to `a`
+// to fit. If this allocation fails, then the failure strategy defers to the
+// existence of `A_F_SOFT_FAIL`.
 void *claim(arena *a, char *buf, usize len, int flags);
 
 // Pop a block of memory `p` with size `len` that has been previously claimed.
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef METANG_CACHE_H
+#define METANG_CACHE_H
+
+#include "alloc.h"
+#include "digest.h"
+#include "meta.h"
+#include "options.h"
+#include "outbuf.h"
+#include "strbuf.h"
+
+// Build the path of the cache entry for the current target of `opts`, given
+// the digest of its input. The key covers the input, every option which can
+// change the output, and the version of metang. `dir` is created if it does
+// not yet exist.
+char *cachepath(arena *a, const str *dir, const u8 input[DIGEST_LEN], const options *opts);
+
+// Build the path under which the source file split from the artifact cached
+// at `path` is stored.
+char *cachesrc(arena *a, const char *path);
+
+// Write the artifact cached at `out->cache` to `out` and, if `out->source` is
+// given, the one cached at its `cache` to it as well, storing in `ok` whether
+// the writes succeeded. Return `false` without writing anything if any of
+// them is missing from the cache.
+bool cachefetch(const outdest *out, bool *ok);
+
+#endif // METANG_CACHE_H
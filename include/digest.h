@@ -0,0 +1,41 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef METANG_DIGEST_H
+#define METANG_DIGEST_H
+
+#include "meta.h"
+
+#define DIGEST_LEN 32
+
+// An incremental SHA-256 digest. Feed it with `dgwrite`, then read the result
+// with `dgfinal`.
+typedef struct digest {
+    u32 state[8];
+    u64 len;       // Number of bytes written so far
+    u8 block[64];  // Bytes not yet compressed
+} digest;
+
+void dginit(digest *d);
+
+// Add `len` bytes from `buf` to the digest.
+void dgwrite(digest *d, const void *buf, usize len);
+
+// Finish the digest and store it in `out`. `d` must be re-initialized before
+// it is used again.
+void dgfinal(digest *d, u8 out[DIGEST_LEN]);
+
+#endif // METANG_DIGEST_H
@@ -19,35 +19,85 @@
 
 #include <stdio.h>
 
+#include "alloc.h"
 #include "options.h"
+#include "outbuf.h"
 #include "strbuf.h"
+#include "template.h"
 
-typedef struct enumerator enumerator;
-struct enumerator {
-    enumerator *next;
-    str ident;
-    isize assignment;
+// The members of an enumeration, stored by column: member `i` is described by
+// element `i` of each array, in declaration order.
+typedef struct enumerator {
+    str *names;         // Identifiers converted to UPPER_SNAKE_CASE
+    isize *assignments; // Values for enums; bit indices for masks
     usize count;
-    usize max_ident_len;
-    usize max_assign_len;
-};
+    usize cap;
+    usize max_ident_len;  // Longest identifier, as written in the input
+    usize max_assign_len; // Longest value, as printed in decimal
+} enumerator;
 
-typedef bool (*generator_func)(enumerator *input, options *opts, FILE *fout);
+typedef bool (*generator_func)(enumerator *input, options *opts, arena *a, const outdest *out);
 
 typedef struct generator {
     str lang;
     generator_func genfunc;
+    tmplset *templates; // Compiled once, at startup
 } generator;
 
 typedef struct outlist {
-    strlist *enums;
-    strlist *procs;
     str *table;
+    isize *values;
 } outlist;
 
+// The fixed text around each member line: the name is followed by `mid`, and
+// the assignment by `post`.
+typedef struct entryfmt {
+    const char *mid;
+    const char *post;
+} entryfmt;
+
+// A value, along with the position at which it was declared.
+typedef struct valpos {
+    isize value;
+    usize pos;
+} valpos;
+
 extern const generator generators[];
 extern const str header_warning;
 extern const str header_source_file;
 extern const str header_program_opts;
 
+// The routines below are shared by the language backends.
+
+// Convert `prefix` to UPPER_SNAKE_CASE and follow it with an underscore. An
+// empty prefix stays empty.
+str make_prefix(arena *a, const str *prefix);
+
+// Convert the basename of `fname` to UPPER_SNAKE_CASE, for use in guards.
+str make_basename(arena *a, const str *fname);
+
+// Collect the name and value of each member in declaration order. Names are
+// stored in `table` following `leader`; masks are stored by value rather than
+// by bit index.
+outlist *stringify(arena *a, enumerator *input, const str *leader, enum options_mode mode);
+
+// Write a line for each member in declaration order: `pre` -> symbol, padded
+// to the longest -> `mid` -> assignment -> `post`. `fmts` holds the formats for
+// a member of an enumeration, then for the first, inner, and last members of
+// a mask, which are written as shifts of their bit index.
+void write_members(enumerator *input, const str *leader, enum options_mode mode, const entryfmt *fmts, const char *pre, outbuf *out);
+
+// Write the naming options given on the command line, one per line, each
+// following `prefix`.
+void write_options(options *opts, const char *prefix, outbuf *out);
+
+// Write the options which altered the input listing, as for `write_options`.
+void write_input_options(options *opts, const char *prefix, outbuf *out);
+
+// Choose the narrowest fixed-width integer type which holds [min, max].
+const char *inttype(isize min, isize max);
+
+// Order `valpos` elements by value, then by declaration.
+int qsort_valcmp(const void *a, const void *b);
+
 #endif // METANG_GENERATE_H
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef METANG_LIBMETANG_H
+#define METANG_LIBMETANG_H
+
+// libmetang generates enumerations in-process, from memory and into memory,
+// without touching any file. For example:
+//
+//     char *args[] = { "--lang", "cpp", "-t", "pokemon" };
+//     options opts;
+//     if (!mtopts(&opts, OPTS_M_ENUM, 4, args)) {
+//         // Describe the failure with `optserr`.
+//     }
+//
+//     arena a = arena_new(1 << 16);
+//     char text[] = "Bulbasaur\nIvysaur\nVenusaur\n";
+//     str listing = { text, sizeof(text) - 1 };
+//     str header;
+//     enumerator *input = mtparse(&a, &listing, &opts);
+//     if (input && mtgenerate(&a, input, &opts, 0, &header, NULL)) {
+//         // `header.buf` holds the output, until `a` is released.
+//     }
+//
+// All of these may be called from several threads at once, so long as each
+// thread uses arenas and options of its own. Errors in the input are reported
+// on standard error, as by the program.
+//
+// This header stands alone; the rest of the program's headers are private to
+// the library, as are the symbols which they declare.
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __GNUC__
+#define METANG_API __attribute__((visibility("default")))
+#else
+#define METANG_API
+#endif
+
+#define METANG_MAX_ADDITIONAL_VALS 16
+#define METANG_MAX_TARGETS         8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A string of `len` bytes at `buf`, which need not be NUL-terminated.
+typedef struct str {
+    char *buf;
+    uintptr_t len;
+} str;
+
+typedef struct arena_block arena_block;
+
+// An arena, from which everything that the library returns is allocated.
+typedef struct arena {
+    char *mem;          // Current memory block
+    uintptr_t cap;      // Total memory capacity of the current block
+    uintptr_t ofs;      // Current "head" offset in the current block
+    uintptr_t reserved; // Size of the reserved address range at `mem`, if any
+    arena_block *chain; // Blocks owned by the arena, most recent first
+    jmp_buf env;        // Where allocation failures jump to; the library sets its own
+} arena;
+
+enum result_code {
+    OPTS_S,
+    OPTS_F_UNRECOGNIZED_OPT,
+    OPTS_F_OPT_MISSING_ARG,
+    OPTS_F_TOO_MANY_APPENDS,
+    OPTS_F_TOO_MANY_PREPENDS,
+    OPTS_F_NOT_AN_INTEGER,
+    OPTS_F_UNRECOGNIZED_LANG,
+    OPTS_F_UNRECOGNIZED_INDEX,
+    OPTS_F_UNRECOGNIZED_LAYOUT,
+    OPTS_F_SOURCE_WITHOUT_OUTPUT,
+    OPTS_F_UNRECOGNIZED_PY_STYLE,
+    OPTS_F_TOO_MANY_TARGETS,
+    OPTS_F_OUTPUT_PER_TARGET,
+};
+
+enum options_mode {
+    OPTS_M_NONE = 0,
+    OPTS_M_ENUM = (1 << 0),
+    OPTS_M_MASK = (1 << 1),
+
+    OPTS_M_ANY = OPTS_M_ENUM | OPTS_M_MASK,
+};
+
+enum options_layout {
+    OPTS_T_AOS,
+    OPTS_T_POOL,
+    OPTS_T_SOA,
+};
+
+enum options_py_style {
+    OPTS_P_CLASS,
+    OPTS_P_CONST,
+    OPTS_P_LAZY,
+};
+
+// Program options, as parsed by `mtopts`.
+typedef struct options {
+    enum options_mode mode;
+    enum result_code result;
+    str last_opt;
+    str last_arg;
+
+    str append[METANG_MAX_ADDITIONAL_VALS];
+    str prepend[METANG_MAX_ADDITIONAL_VALS];
+    uint16_t append_count;
+    uint16_t prepend_count;
+
+    intptr_t start;
+    str leader;
+    str tag;
+    str guard;
+    str outfile;
+    str infile;
+    str srcfile;
+    str cachedir;
+
+    // Every target language is generated from the same parse. Outputs pair
+    // with targets in order; `lang`, `genf`, and `outfile` hold the target
+    // currently being generated.
+    str lang;
+    uintptr_t genf;
+    uintptr_t targets[METANG_MAX_TARGETS];
+    str outfiles[METANG_MAX_TARGETS];
+    uint16_t target_count;
+    uint16_t outfile_count;
+
+    uint32_t index;
+    uint32_t threads; // Most threads one job may use; 0 for one per processor
+    enum options_layout layout;
+    enum options_py_style py_style;
+
+    union {
+        struct {
+            uint32_t set_leader : 1;
+            uint32_t set_tag    : 1;
+            uint32_t set_guard  : 1;
+            uint32_t set_start  : 1;
+        };
+        uint32_t flags;
+    };
+} options;
+
+// The members of a parsed listing. Its contents are private to the library.
+typedef struct enumerator enumerator;
+
+// Create an arena with at least `cap` bytes available, which grows as the
+// library allocates from it. Release the arena with `arena_free`.
+METANG_API arena arena_new(uintptr_t cap);
+
+// Release every block owned by the arena `a`.
+METANG_API void arena_free(arena *a);
+
+// Parse the program options in `argv`, which follow the command `mode`, into
+// `opts`. The final argument, if it is not an option, names the input; it is
+// not opened, but its name is written into the output and used to derive the
+// default tag. Return `false` if the options are invalid, in which case
+// `optserr` describes why.
+METANG_API bool mtopts(options *opts, enum options_mode mode, int argc, char **argv);
+
+// Write a NUL-terminated description of why `opts` failed to parse into
+// `sbuf->buf`.
+METANG_API void optserr(options *opts, str *sbuf);
+
+// Parse the listing in `text` into the members of an enumeration, allocated
+// from `a`. Return `NULL` if the listing is invalid, defines no members, or
+// `a` is exhausted.
+METANG_API enumerator *mtparse(arena *a, const str *text, const options *opts);
+
+// Generate the enumeration `input` for the target language at position
+// `target` of those given by `opts`, storing the output in `out`. If `opts`
+// splits the lookup tables into a source file, then that is stored in `src`,
+// which must then be given. Both are allocated from `a`, and NUL-terminated.
+// Return `false` if generation fails.
+METANG_API bool mtgenerate(arena *a, enumerator *input, options *opts, uintptr_t target, str *out, str *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METANG_LIBMETANG_H
@@ -17,6 +17,7 @@
 #ifndef METANG_META_H
 #define METANG_META_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -24,21 +25,17 @@
 #define countof(a)  (sizeof(a) / sizeof(*(a)))
 #define lengthof(s) (countof(s) - 1)
 
-#define false 0
-#define true  1
-
 // clang-format off
 typedef uint8_t         u8;
 typedef uint16_t        u16;
 typedef uint32_t        u32;
+typedef uint64_t        u64;
 typedef int8_t          i8;
 typedef int16_t         i16;
 typedef int32_t         i32;
 typedef intptr_t        isize;
 typedef uintptr_t       usize;
 
-typedef int32_t         bool;
-
 typedef unsigned char   byte;
 // clang-format on
 
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef METANG_OUTBUF_H
+#define METANG_OUTBUF_H
+
+#include <stdio.h>
+
+#include "alloc.h"
+#include "meta.h"
+#include "strbuf.h"
+
+// An output artifact, rendered into a single contiguous block of arena memory
+// and written out all at once by `obflush` or `obcommit`.
+typedef struct outbuf {
+    arena *a;  // Arena from which the block is allocated
+    char *buf; // Rendered output
+    usize len; // Number of bytes rendered so far
+    usize cap; // Capacity of `buf`
+} outbuf;
+
+// Where an artifact is written: into memory from `mem`, if given; else the file
+// at `path`, if given; or else the already-open `stream`. If `cache` is given,
+// then a copy is also stored there.
+typedef struct outdest {
+    const char *path;
+    FILE *stream;
+    const char *cache;
+
+    arena *mem; // Arena which receives a NUL-terminated copy
+    str *text;  // Set to refer to that copy
+
+    // Where a source file split from the artifact is written. If `NULL`, then
+    // it is written to the file named by the program options.
+    const struct outdest *source;
+} outdest;
+
+// Create an output buffer in the arena `a` with an initial capacity of `cap`.
+// The buffer grows as needed, extending in place if it is the most recent
+// allocation in `a`; failures jump to `a->env`.
+outbuf obnew(arena *a, usize cap);
+
+// Append `len` bytes from `s`.
+void obwrite(outbuf *ob, const char *s, usize len);
+
+// Append the NUL-terminated string `s`.
+void obputs(outbuf *ob, const char *s);
+
+// Append the contents of `s`.
+void obstr(outbuf *ob, const str *s);
+
+// Append `n` copies of the character `c`.
+void obpad(outbuf *ob, char c, usize n);
+
+// Append `v` in decimal, right-aligned in a field of `width` characters.
+void obint(outbuf *ob, isize v, usize width);
+
+// Write the entire contents of the buffer to `f` and empty it. Return `false`
+// if the write fails.
+bool obflush(outbuf *ob, FILE *f);
+
+// Write the entire contents of the buffer to `dest` and empty it. Return
+// `false` if the write fails.
+//
+// A regular file at `dest->path` is left untouched, mtime included, if it
+// already holds exactly these contents; otherwise, it is replaced atomically
+// by renaming a temporary file over it. Anything else at `dest->path`, such
+// as a device or a pipe, is written through in place.
+//
+// Output written to `dest->mem` is copied without touching any file, and
+// outlives the arena from which `ob` was allocated.
+//
+// The copy at `dest->cache` is stored the same way, and synced to disk before
+// it is renamed into place, but is best-effort: if it cannot be stored, then
+// the output is still written.
+bool obcommit(outbuf *ob, const outdest *dest);
+
+// Count the characters needed to print `v` in decimal.
+usize intlen(isize v);
+
+#endif // METANG_OUTBUF_H
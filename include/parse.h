@@ -0,0 +1,31 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef METANG_PARSE_H
+#define METANG_PARSE_H
+
+#include "alloc.h"
+#include "generator.h"
+#include "options.h"
+#include "strbuf.h"
+
+// Parse the listing in `text` into the members of an enumeration, allocated
+// from `a`, including any members prepended or appended by `opts`. Invalid
+// input, including input which defines no members at all, is reported on
+// standard error, then jumps to `a->env`.
+enumerator *enumerate(arena *a, str text, const options *opts);
+
+#endif // METANG_PARSE_H
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef METANG_SERVE_H
+#define METANG_SERVE_H
+
+#include "meta.h"
+
+// The descriptors which a client lends to the server for one request.
+enum request_fd {
+    REQ_STDIN,
+    REQ_STDOUT,
+    REQ_STDERR,
+    REQ_CWD,
+
+    NUM_REQ_FDS,
+};
+
+// A job sent by a client, to be run as if the client had run it itself: with
+// its arguments, its standard streams, and its working directory.
+typedef struct request {
+    int conn;
+    int fds[NUM_REQ_FDS];
+    int argc;
+    char **argv;
+    char *args; // Backing storage for `argv`
+} request;
+
+// Listen for clients on a Unix socket bound to `path`. A stale socket left at
+// `path` is replaced, but one with a live server behind it is not, nor is
+// anything at `path` which is not a socket. Return the
+// listening socket, or -1 if it could not be created.
+int srvlisten(const char *path);
+
+// Wait for the next well-formed request on `sock`. Malformed requests, and
+// those which stall partway through, are dropped. Return `false` if waiting was interrupted by a signal or failed.
+bool srvaccept(int sock, request *req);
+
+// Send the exit status of a request to its client, then release it.
+void srvreply(request *req, int exit);
+
+// Send `argv` to the server listening at `path`, along with this process's
+// standard streams and working directory, and wait for it to finish. Return
+// `false` if no server accepted the request, in which case nothing was run.
+bool srvforward(const char *path, int argc, char **argv, int *exit);
+
+#endif // METANG_SERVE_H
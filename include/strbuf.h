@@ -18,6 +18,7 @@
 #define METANG_STRBUF_H
 
 #include "alloc.h"
+#include "libmetang.h"
 #include "meta.h"
 
 // clang-format off
@@ -37,11 +38,6 @@
     }
 // clang-format on
 
-typedef struct str {
-    char *buf;
-    usize len;
-} str;
-
 typedef struct strpair {
     str head;
     str tail;
@@ -79,6 +75,12 @@ str strchop(const str *s, char c);
 // converted.
 bool strtolong(const str *s, long *l);
 
+// Sort the `n` strings in `v` into the same order as `strcmp`, but without
+// calling through a comparator and without rescanning bytes that are already
+// known to be shared. Very large inputs are split across up to `threads`
+// threads, or one per processor if `threads` is 0.
+void strsort(str *v, usize n, unsigned threads);
+
 #define S_SNAKE_F_LOWER false
 #define S_SNAKE_F_UPPER true
 
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef METANG_TEMPLATE_H
+#define METANG_TEMPLATE_H
+
+#include "alloc.h"
+#include "meta.h"
+#include "outbuf.h"
+
+// A template is output text with named slots, written as `${name}`, which are
+// filled in when it is rendered. Templates are compiled ahead of use into a
+// program of segments, each of which either copies a span of the text or
+// emits the value bound to a slot, so that rendering never rescans the text.
+typedef struct tmplseg {
+    const char *text; // Literal text to copy, or NULL for a slot
+    usize len;        // Length of `text`
+    usize slot;       // Index of the slot's value among the render arguments
+} tmplseg;
+
+typedef struct template {
+    tmplseg *segs;
+    usize count;
+} template;
+
+// The value bound to a slot: a string, another template rendered against the
+// same arguments, or an integer printed in decimal. A slot which was never
+// bound is zeroed, and so has no kind; rendering it is a bug.
+enum tmplkind {
+    TMPL_K_UNSET,
+    TMPL_K_STR,
+    TMPL_K_TMPL,
+    TMPL_K_INT,
+};
+
+typedef struct tmplarg {
+    enum tmplkind kind;
+    union {
+        const char *s;
+        const template *t;
+        isize n;
+    };
+} tmplarg;
+
+#define TSTR(x)  ((tmplarg){ .kind = TMPL_K_STR, .s = (x) })
+#define TTMPL(x) ((tmplarg){ .kind = TMPL_K_TMPL, .t = (x) })
+#define TINT(x)  ((tmplarg){ .kind = TMPL_K_INT, .n = (x) })
+
+// The templates of a backend, along with the names of the slots which they may
+// use. A slot's value is passed to `tmplrender` at the same position as its
+// name in `slots`.
+typedef struct tmplset {
+    const char *const *srcs;
+    usize count;
+    const char *const *slots;
+    usize nslots;
+    template *compiled; // Filled by `tmplcompile`; one for each of `srcs`
+} tmplset;
+
+// Compile every template of `set` from memory in `a`. Return `false` and
+// report the offending template if any refers to an unknown slot or leaves
+// one unterminated.
+bool tmplcompile(arena *a, tmplset *set);
+
+// Render the template `t` into `out`, taking the value of each slot from
+// `args`. Every slot which `t` uses must be bound.
+void tmplrender(outbuf *out, const template *t, const tmplarg *args);
+
+#endif // METANG_TEMPLATE_H
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#define _DEFAULT_SOURCE
+
 #include "alloc.h"
 
 #include <setjmp.h>
@@ -21,13 +23,112 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Address space reserved at a time by an arena; only committed pages count
+// against memory. This is kept small enough to fit under a modest `ulimit -v`,
+// and an arena which exhausts it reserves another.
+#define ARENA_RESERVE ((usize)1 << (sizeof(usize) > 4 ? 30 : 28))
+
+// Each block owned by an arena is prefixed by a link to the block chained
+// before it. A reserved block's header takes the first page of its mapping,
+// so that its memory starts on the page after.
+struct arena_block {
+    arena_block *prev;
+    usize reserved; // Size of the reserved range after the header's page, or 0 on the heap
+    _Alignas(max_align_t) char mem[];
+};
+
+static bool chain(arena *a, usize cap)
+{
+    arena_block *block = malloc(sizeof(arena_block) + cap);
+    if (block == NULL) {
+        return false;
+    }
+
+    block->prev = a->chain;
+    block->reserved = 0;
+    a->chain = block;
+    a->mem = block->mem;
+    a->cap = cap;
+    a->ofs = 0;
+    a->reserved = 0;
+    return true;
+}
+
+// Reserve a range of address space for at least `cap` bytes, commit the pages
+// holding the first `cap` of them, and chain it on to the arena.
+static bool reserve(arena *a, usize cap)
+{
+    usize page = sysconf(_SC_PAGESIZE);
+    usize tcap = (cap + page - 1) & ~(page - 1);
+    usize size = tcap > ARENA_RESERVE ? tcap : ARENA_RESERVE;
+
+    char *base = mmap(NULL, page + size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+
+    if (mprotect(base, page + tcap, PROT_READ | PROT_WRITE) != 0) {
+        munmap(base, page + size);
+        return false;
+    }
+
+    arena_block *block = (arena_block *)base;
+    block->prev = a->chain;
+    block->reserved = size;
+    a->chain = block;
+    a->mem = base + page;
+    a->cap = tcap;
+    a->ofs = 0;
+    a->reserved = size;
+    return true;
+}
+
+static void release(arena_block *block)
+{
+    if (block->reserved) {
+        munmap(block, sysconf(_SC_PAGESIZE) + block->reserved);
+    } else {
+        free(block);
+    }
+}
+
+// Commit pages of a reserved arena until at least `need` bytes are usable,
+// growing by at least doubling to keep the number of calls to `mprotect`
+// logarithmic.
+static bool commit(arena *a, usize need)
+{
+    if (need > a->reserved) {
+        return false;
+    }
+
+    usize page = sysconf(_SC_PAGESIZE);
+    usize tcap = a->cap * 2 > need ? a->cap * 2 : need;
+    tcap = (tcap + page - 1) & ~(page - 1);
+    tcap = tcap < a->reserved ? tcap : a->reserved;
+
+    if (mprotect(a->mem + a->cap, tcap - a->cap, PROT_READ | PROT_WRITE) != 0) {
+        return false;
+    }
+
+    a->cap = tcap;
+    return true;
+}
 
 arena arena_new(usize cap)
 {
     arena a = {0};
-    a.mem = malloc(cap);
-    a.cap = cap;
-    a.ofs = 0;
+    if (reserve(&a, cap)) {
+        return a;
+    }
+
+    // If the address space cannot be reserved, then fall back to the heap.
+    if (!chain(&a, cap)) {
+        a.cap = 0;
+    }
+
     return a;
 }
 
@@ -37,9 +138,63 @@ arena arena_from(char *mem, usize cap)
         .mem = mem,
         .cap = cap,
         .ofs = 0,
+        .chain = NULL,
+    };
+}
+
+void arena_free(arena *a)
+{
+    while (a->chain) {
+        arena_block *prev = a->chain->prev;
+        release(a->chain);
+        a->chain = prev;
+    }
+
+    a->mem = NULL;
+    a->cap = 0;
+    a->ofs = 0;
+    a->reserved = 0;
+}
+
+arena_mark checkpoint(arena *a)
+{
+    return (arena_mark){
+        .mem = a->mem,
+        .cap = a->cap,
+        .ofs = a->ofs,
+        .chain = a->chain,
     };
 }
 
+void rollback(arena *a, arena_mark mark)
+{
+    // A reserved block keeps any pages committed since the mark.
+    bool same = a->chain == mark.chain;
+    while (a->chain != mark.chain) {
+        arena_block *prev = a->chain->prev;
+        release(a->chain);
+        a->chain = prev;
+    }
+
+    a->mem = mark.mem;
+    a->cap = same && a->reserved ? a->cap : mark.cap;
+    a->ofs = mark.ofs;
+    a->reserved = a->chain ? a->chain->reserved : 0;
+}
+
+void scratch_begin(scratch *s, arena *a)
+{
+    s->a = a;
+    s->mark = checkpoint(a);
+    memcpy(s->env, a->env, sizeof(jmp_buf));
+}
+
+void scratch_end(scratch *s)
+{
+    rollback(s->a, s->mark);
+    memcpy(s->a->env, s->env, sizeof(jmp_buf));
+}
+
 usize nextofs(arena *a, usize align)
 {
     // Exploit two's complement to get the padding; to illustrate, suppose
@@ -61,14 +216,17 @@ void *alloc(arena *a, usize size, usize align, usize n, int flags)
     void *p;
 
     if (next > a->cap || req_size > remaining) {
-        if (flags & A_F_EXTEND) {
-            usize tcap = (a->cap + req_size) * 2;
-            char *tmem = realloc(a->mem, tcap);
-            if (tmem != NULL) {
-                a->mem = tmem;
-                a->cap = tcap;
-                goto advance;
-            }
+        if (a->reserved && commit(a, next + req_size)) {
+            goto advance;
+        }
+
+        // The remainder of the current block is abandoned; a fresh block is
+        // aligned for any type, so the request always starts at its head. An
+        // exhausted reservation is followed by another, if one can be made.
+        usize tcap = a->cap * 2 > req_size ? a->cap * 2 : req_size;
+        if ((flags & A_F_EXTEND) && ((a->reserved && reserve(a, req_size)) || chain(a, tcap))) {
+            next = 0;
+            goto advance;
         }
 
         if (flags & A_F_SOFT_FAIL) {
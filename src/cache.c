@@ -0,0 +1,163 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cache.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "version.h"
+
+// Every field is written with its length, so that no two keys run together.
+static void dgstr(digest *d, const str *s)
+{
+    u64 len = s->len;
+    dgwrite(d, &len, sizeof(len));
+    dgwrite(d, s->buf, s->len);
+}
+
+static void dgint(digest *d, u64 v)
+{
+    dgwrite(d, &v, sizeof(v));
+}
+
+char *cachepath(arena *a, const str *dir, const u8 input[DIGEST_LEN], const options *opts)
+{
+    digest d;
+    dginit(&d);
+    dgstr(&d, &strnew("metang " METANG_VERSION));
+    dgwrite(&d, input, DIGEST_LEN);
+
+    dgstr(&d, &opts->lang);
+    dgint(&d, opts->mode);
+    dgint(&d, opts->start);
+    dgint(&d, opts->index);
+    dgint(&d, opts->layout);
+    dgint(&d, opts->py_style);
+    dgint(&d, opts->flags);
+    dgstr(&d, &opts->leader);
+    dgstr(&d, &opts->tag);
+    dgstr(&d, &opts->guard);
+    dgstr(&d, &opts->outfile);
+    dgstr(&d, &opts->infile);
+    dgstr(&d, &opts->srcfile);
+
+    dgint(&d, opts->append_count);
+    for (usize i = 0; i < opts->append_count; i++) {
+        dgstr(&d, &opts->append[i]);
+    }
+
+    dgint(&d, opts->prepend_count);
+    for (usize i = 0; i < opts->prepend_count; i++) {
+        dgstr(&d, &opts->prepend[i]);
+    }
+
+    u8 key[DIGEST_LEN];
+    dgfinal(&d, key);
+
+    // A failure here surfaces as a miss, and again when the entry is stored.
+    mkdir(dir->buf, 0777);
+
+    static const char hex[] = "0123456789abcdef";
+    char *path = new (a, char, dir->len + 1 + DIGEST_LEN * 2 + 1, A_F_ZERO);
+    memcpy(path, dir->buf, dir->len);
+    path[dir->len] = '/';
+
+    char *p = path + dir->len + 1;
+    for (usize i = 0; i < DIGEST_LEN; i++) {
+        *p++ = hex[key[i] >> 4];
+        *p++ = hex[key[i] & 0xF];
+    }
+
+    return path;
+}
+
+typedef struct entry {
+    int fd;
+    outbuf ob;
+} entry;
+
+// Open and map a cache entry. Entries are only ever replaced by renaming, once
+// synced to disk, so the mapping holds one complete artifact even if another
+// process stores the same entry meanwhile, or the system crashed as one was
+// stored.
+static bool openentry(const char *path, entry *e)
+{
+    e->fd = open(path, O_RDONLY);
+    e->ob = (outbuf){0};
+
+    struct stat st;
+    if (e->fd < 0 || fstat(e->fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+
+    e->ob.len = e->ob.cap = st.st_size;
+    if (st.st_size > 0) {
+        e->ob.buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, e->fd, 0);
+        if (e->ob.buf == MAP_FAILED) {
+            e->ob.buf = NULL;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void closeentry(entry *e)
+{
+    if (e->ob.buf) {
+        munmap(e->ob.buf, e->ob.cap);
+    }
+
+    if (e->fd >= 0) {
+        close(e->fd);
+    }
+}
+
+char *cachesrc(arena *a, const char *path)
+{
+    usize len = strlen(path);
+    char *src = new (a, char, len + sizeof(".src"), A_F_EXTEND);
+    memcpy(src, path, len);
+    memcpy(src + len, ".src", sizeof(".src"));
+    return src;
+}
+
+bool cachefetch(const outdest *out, bool *ok)
+{
+    entry hdr = { .fd = -1 };
+    entry src = { .fd = -1 };
+
+    bool hit = openentry(out->cache, &hdr);
+    if (hit && out->source) {
+        hit = openentry(out->source->cache, &src);
+    }
+
+    // The source is written first, as when generating.
+    if (hit) {
+        *ok = out->source == NULL || obcommit(&src.ob, &(outdest){ .path = out->source->path });
+        *ok = obcommit(&hdr.ob, &(outdest){ .path = out->path, .stream = out->stream }) && *ok;
+    }
+
+    closeentry(&hdr);
+    closeentry(&src);
+    return hit;
+}
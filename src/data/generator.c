@@ -20,13 +20,19 @@
 
 #include "strbuf.h"
 
-extern bool generate_c(enumerator *input, options *opts, FILE *fout);
-extern bool generate_py(enumerator *input, options *opts, FILE *fout);
+extern bool generate_c(enumerator *input, options *opts, arena *a, const outdest *out);
+extern bool generate_py(enumerator *input, options *opts, arena *a, const outdest *out);
+extern bool generate_cpp(enumerator *input, options *opts, arena *a, const outdest *out);
+
+extern tmplset c_templates;
+extern tmplset py_templates;
+extern tmplset cpp_templates;
 
 // clang-format off
 const generator generators[] = {
-    { strnew("c"),          generate_c          }, // default; must ALWAYS be first!
-    { strnew("py"),         generate_py         },
-    { strZ,                 NULL                }, // must ALWAYS be last!
+    { strnew("c"),          generate_c,         &c_templates   }, // default; must ALWAYS be first!
+    { strnew("py"),         generate_py,        &py_templates  },
+    { strnew("cpp"),        generate_cpp,       &cpp_templates },
+    { strZ,                 NULL,               NULL           }, // must ALWAYS be last!
 };
 // clang-format on
@@ -28,6 +28,11 @@ const str commands_section = strnew(""
     "Commands:\n"
     "  enum     Generate an integral enumeration.\n"
     "  mask     Generate a bitmask enumeration.\n"
+    "  batch    Run every job listed in a manifest file. Use -j <N> to run\n"
+    "           up to <N> jobs at once, or -j 0 for one per processor.\n"
+    "  serve    Run jobs sent by clients over the Unix socket given by\n"
+    "           --socket <PATH>. Set METANG_SOCKET to <PATH> to forward\n"
+    "           any other command to it.\n"
     "  help     Display this help text.\n"
     "  version  Display the version number of this program."
     "");
@@ -36,16 +41,37 @@ const str global_options_section = strnew(""
     "Global Options:\n"
     "  -L, --lang <LANG>        Generate the enumeration for a target language.\n"
     "                           If unspecified, generate for the C language.\n"
-    "                           Options: c, py\n"
+    "                           May be a comma-separated list, in which case\n"
+    "                           the input is read once for all languages.\n"
+    "                           Options: c, cpp, py\n"
     "  -o, --output <OFILE>     Write output to <OFILE>.\n"
     "                           If unspecified, write to standard output.\n"
+    "                           If --lang lists more than one language, give\n"
+    "                           this once per language, in the same order.\n"
     "  -l, --leader <LEADER>    Use <LEADER> as a prefix for generated symbols.\n"
     "  -t, --tag-name <NAME>    Use <NAME> as the base tag for enums and lookup\n"
     "                           tables.\n"
     "                           If unspecified, <NAME> will be derived from the\n"
     "                           input file's basename, minus any extension.\n"
     "  -G, --guard <GUARD>      Prefix conditional directives with <GUARD>. For\n"
-    "                           example, in C, this will prefix inclusion guards."
+    "                           example, in C, this will prefix inclusion guards.\n"
+    "  -i, --index <KIND>       Generate a lookup function of kind <KIND> over\n"
+    "                           the lookup table. May be specified more than once.\n"
+    "                           Only applicable to the C language.\n"
+    "                           Options: bsearch, hash, reverse, switch\n"
+    "  -T, --layout <LAYOUT>    Store the lookup table using layout <LAYOUT>.\n"
+    "                           Only applicable to the C language.\n"
+    "                           Options: aos, pool, soa\n"
+    "  -s, --source <CFILE>     Write lookup tables to <CFILE> rather than to\n"
+    "                           <OFILE>, which will only declare them.\n"
+    "                           Requires --output. Only applicable to the C\n"
+    "                           language.\n"
+    "  -P, --py-style <STYLE>   Emit the enumeration using style <STYLE>.\n"
+    "                           Only applicable to the Python language.\n"
+    "                           Options: class, const, lazy\n"
+    "  -C, --cache-dir <DIR>    Store each output in <DIR>, keyed by the input\n"
+    "                           and options, and copy it from there when\n"
+    "                           neither has changed."
     "");
 
 const str enum_options_section = strnew(""
@@ -63,7 +89,9 @@ const str mask_notes_section = strnew(""
     "  2. Overrides on assignment values from user input are not permitted. This is\n"
     "     to ensure that the generated bitmask is contiguous.\n"
     "  3. As a consequence of (1) and (2), overrides to the starting value are not\n"
-    "     permitted."
+    "     permitted.\n"
+    "  4. A bitmask may hold at most 63 flags, so that ANY fits in a signed 64-bit\n"
+    "     value."
     "");
 
 const str header_warning = strnew("This file was generated by metang; DO NOT MODIFY IT!!");
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "digest.h"
+
+#include <string.h>
+
+// clang-format off
+static const u32 k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+// clang-format on
+
+static inline u32 ror(u32 x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+static void compress(u32 state[8], const u8 block[64])
+{
+    u32 w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (u32)block[i * 4] << 24
+            | (u32)block[i * 4 + 1] << 16
+            | (u32)block[i * 4 + 2] << 8
+            | (u32)block[i * 4 + 3];
+    }
+
+    for (int i = 16; i < 64; i++) {
+        u32 s0 = ror(w[i - 15], 7) ^ ror(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        u32 s1 = ror(w[i - 2], 17) ^ ror(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    u32 a = state[0], b = state[1], c = state[2], d = state[3];
+    u32 e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        u32 t1 = h + (ror(e, 6) ^ ror(e, 11) ^ ror(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+        u32 t2 = (ror(a, 2) ^ ror(a, 13) ^ ror(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void dginit(digest *d)
+{
+    static const u32 init[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+
+    memcpy(d->state, init, sizeof(init));
+    d->len = 0;
+}
+
+void dgwrite(digest *d, const void *buf, usize len)
+{
+    const u8 *p = buf;
+    usize fill = d->len % 64;
+    d->len += len;
+
+    if (fill > 0) {
+        usize n = 64 - fill < len ? 64 - fill : len;
+        memcpy(d->block + fill, p, n);
+        p += n;
+        len -= n;
+        if (fill + n < 64) {
+            return;
+        }
+
+        compress(d->state, d->block);
+    }
+
+    for (; len >= 64; p += 64, len -= 64) {
+        compress(d->state, p);
+    }
+
+    memcpy(d->block, p, len);
+}
+
+void dgfinal(digest *d, u8 out[DIGEST_LEN])
+{
+    u64 bits = d->len * 8;
+    usize fill = d->len % 64;
+
+    d->block[fill++] = 0x80;
+    if (fill > 56) {
+        memset(d->block + fill, 0, 64 - fill);
+        compress(d->state, d->block);
+        fill = 0;
+    }
+
+    memset(d->block + fill, 0, 56 - fill);
+    for (int i = 0; i < 8; i++) {
+        d->block[56 + i] = (u8)(bits >> (56 - i * 8));
+    }
+    compress(d->state, d->block);
+
+    for (int i = 0; i < 8; i++) {
+        out[i * 4] = (u8)(d->state[i] >> 24);
+        out[i * 4 + 1] = (u8)(d->state[i] >> 16);
+        out[i * 4 + 2] = (u8)(d->state[i] >> 8);
+        out[i * 4 + 3] = (u8)d->state[i];
+    }
+}
@@ -0,0 +1,165 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "generator.h"
+#include "meta.h"
+#include "options.h"
+#include "outbuf.h"
+#include "strbuf.h"
+
+str make_prefix(arena *a, const str *prefix)
+{
+    char *buf = new (a, char, prefix->len + 2, A_F_ZERO | A_F_EXTEND);
+    if (prefix->len == 0) {
+        return strnew(buf, 0);
+    }
+
+    str cased = strsnake(prefix, buf, NULL, S_SNAKE_F_UPPER);
+    cased.buf[cased.len] = '_';
+    cased.buf[cased.len + 1] = '\0';
+    cased.len++;
+
+    return cased;
+}
+
+str make_basename(arena *a, const str *fname)
+{
+    str fbase = strrcut(fname, '/').tail;
+    char *buf = new (a, char, fbase.len + 1, A_F_ZERO | A_F_EXTEND);
+    return strsnake(&fbase, buf, &strnew("."), S_SNAKE_F_UPPER);
+}
+
+outlist *stringify(arena *a, enumerator *input, const str *leader, enum options_mode mode)
+{
+    outlist *outputs = new (a, outlist, 1, A_F_ZERO | A_F_EXTEND);
+    outputs->table = new (a, str, input->count, A_F_ZERO | A_F_EXTEND);
+    outputs->values = new (a, isize, input->count, A_F_ZERO | A_F_EXTEND);
+
+    for (usize i = 0; i < input->count; i++) {
+        const str *name = &input->names[i];
+        if (leader->len == 0) {
+            outputs->table[i] = *name;
+        } else {
+            char *buf = new (a, char, leader->len + name->len + 1, A_F_ZERO | A_F_EXTEND);
+            memcpy(buf, leader->buf, leader->len);
+            memcpy(buf + leader->len, name->buf, name->len);
+            outputs->table[i] = strnew(buf, leader->len + name->len);
+        }
+
+        isize assignment = input->assignments[i];
+        if (mode == OPTS_M_ENUM) {
+            outputs->values[i] = assignment;
+        } else if (i == 0) {
+            outputs->values[i] = 0;
+        } else if (i == input->count - 1) {
+            outputs->values[i] = (isize)(((usize)1 << (assignment - 1)) - 1);
+        } else {
+            outputs->values[i] = (isize)((usize)1 << (assignment - 1));
+        }
+    }
+
+    return outputs;
+}
+
+void write_members(enumerator *input, const str *leader, enum options_mode mode, const entryfmt *fmts, const char *pre, outbuf *out)
+{
+    usize column = leader->len + input->max_ident_len;
+    for (usize i = 0; i < input->count; i++) {
+        const entryfmt *fmt = &fmts[0];
+        isize assignment = input->assignments[i];
+        if (mode == OPTS_M_MASK) {
+            fmt = i == 0              ? &fmts[1]
+                : i == input->count - 1 ? &fmts[3]
+                                        : &fmts[2];
+            assignment = i == 0 ? 0 : assignment - 1;
+        }
+
+        const str *name = &input->names[i];
+        obputs(out, pre);
+        obstr(out, leader);
+        obstr(out, name);
+        obpad(out, ' ', column - leader->len - name->len);
+        obputs(out, fmt->mid);
+        obint(out, assignment, input->max_assign_len);
+        obputs(out, fmt->post);
+    }
+}
+
+void write_options(options *opts, const char *prefix, outbuf *out)
+{
+    if (opts->set_leader) {
+        obputs(out, prefix);
+        obputs(out, "--leader ");
+        obstr(out, &opts->leader);
+        obputs(out, "\n");
+    }
+
+    if (opts->set_tag) {
+        obputs(out, prefix);
+        obputs(out, "--tag-name ");
+        obstr(out, &opts->tag);
+        obputs(out, "\n");
+    }
+
+    if (opts->set_guard) {
+        obputs(out, prefix);
+        obputs(out, "--guard ");
+        obstr(out, &opts->guard);
+        obputs(out, "\n");
+    }
+}
+
+void write_input_options(options *opts, const char *prefix, outbuf *out)
+{
+    if (opts->mode & OPTS_M_MASK) {
+        return;
+    }
+
+    for (usize i = 0; i < opts->append_count; i++) {
+        obputs(out, prefix);
+        obputs(out, "--append ");
+        obstr(out, &opts->append[i]);
+        obputs(out, "\n");
+    }
+
+    for (usize i = 0; i < opts->prepend_count; i++) {
+        obputs(out, prefix);
+        obputs(out, "--prepend ");
+        obstr(out, &opts->prepend[i]);
+        obputs(out, "\n");
+    }
+
+    if (opts->set_start) {
+        obputs(out, prefix);
+        obputs(out, "--start-from ");
+        obint(out, opts->start, 0);
+        obputs(out, "\n");
+    }
+}
+
+const char *inttype(isize min, isize max)
+{
+    if (min >= 0) {
+        return max <= UINT8_MAX    ? "uint8_t"
+            : max <= UINT16_MAX    ? "uint16_t"
+            : (usize)max <= UINT32_MAX ? "uint32_t"
+                                   : "uint64_t";
+    }
+
+    return min >= INT8_MIN && max <= INT8_MAX     ? "int8_t"
+        : min >= INT16_MIN && max <= INT16_MAX ? "int16_t"
+        : min >= INT32_MIN && max <= INT32_MAX ? "int32_t"
+                                               : "int64_t";
+}
+
+int qsort_valcmp(const void *a, const void *b)
+{
+    const valpos *v1 = a;
+    const valpos *v2 = b;
+    if (v1->value != v2->value) {
+        return (v1->value > v2->value) - (v1->value < v2->value);
+    }
+
+    return (v1->pos > v2->pos) - (v1->pos < v2->pos);
+}
@@ -1,3 +1,4 @@
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,343 +7,1350 @@
 #include "generator.h"
 #include "meta.h"
 #include "options.h"
+#include "outbuf.h"
 #include "strbuf.h"
+#include "template.h"
 
-static outlist *stringify(enumerator *input, const str *leader, enum options_mode mode);
-static void stringify_enumeration(enumerator *input, const str *leader, outlist *outputs, usize max_ident_len);
-static void stringify_bitmask(enumerator *input, const str *leader, outlist *outputs, usize max_ident_len);
+typedef struct reverse {
+    isize min;
+    isize max;
+    usize span;   // Number of members in `order`
+    isize *order; // Declaration positions; see `build_reverse`
+    bool dense;
+} reverse;
 
-static void write_options(options *opts, FILE *fout);
-static str make_prefix(const str *prefix);
-static str make_basename(const str *fname);
+// Slots which may be used by the templates below.
+enum slot {
+    S_WARNING,
+    S_MODE,
+    S_INFILE,
+    S_GUARD,
+    S_BASENAME,
+    S_INCLUDE,
+    S_TAG,
+    S_COUNT,
+    S_SPAN,
+    S_MIN,
+    S_MAX,
+    S_VALUE_TYPE,
+    S_OFFSET_TYPE,
+    S_NAMELEN_TYPE,
+    S_INDEX_TYPE,
+    S_DISP_TYPE,
+    S_SLOT_TYPE,
+    S_FUNC,
+    S_DEF,
+    S_LEN,
+    S_ELEM,
+    S_RDEF,
+    S_VALUE,
+
+    NUM_SLOTS,
+};
+
+enum tmpl {
+    T_HEADER,
+    T_INIT_GUARDS,
+    T_INCLUDES,
+    T_INIT_ENUM,
+    T_LOOKUP_BRANCH,
+    T_ENTRY_DEF,
+    T_ENTRY_POOL,
+    T_ENTRY_SOA,
+    T_LOOKUP_DECLS,
+    T_SPLIT_DECLS,
+    T_POOL_DECL,
+    T_SOA_DECLS,
+    T_LOOKUP_DECL,
+    T_NAMELEN_DECL,
+    T_NAMES_INDEX_DECL,
+    T_BYVALUE_INDEX_DECL,
+    T_NAMES_POOL_DECL,
+    T_NAMES_DECL,
+    T_BYVALUE_DECL,
+    T_SOURCE_INIT,
+    T_LOOKUP_IMPL,
+    T_LOOKUP_TABLE,
+    T_POOL_TABLE,
+    T_VALUES_TABLE,
+    T_OFFSETS_ARRAY,
+    T_NAMELEN_ARRAY,
+    T_NAMES_INDEX_ARRAY,
+    T_BYVALUE_INDEX_ARRAY,
+    T_NAMES_POOL_ARRAY,
+    T_NAMES_TABLE,
+    T_BYVALUE_TABLE,
+    T_TABLE_FOOTER,
+    T_HASH_FUNC,
+    T_DISP_ARRAY,
+    T_SLOT_ARRAY,
+    T_FIND_BODY,
+    T_BSEARCH_FUNC,
+    T_SWITCH_FUNC,
+    T_SWITCH_FOOTER,
+    T_PARSE_FUNC,
+    T_REVERSE_DENSE,
+    T_REVERSE_POOL,
+    T_REVERSE_SOA,
+    T_REVERSE_SPARSE,
+    T_REVERSE_SPARSE_SOA,
+    T_FOOTER,
+    T_AOS_DEF,
+    T_AOS_LEN,
+    T_AOS_ELEM,
+    T_AOS_RDEF,
+    T_POOL_DEF,
+    T_POOL_LEN,
+    T_POOL_ELEM,
+    T_POOL_RDEF,
+    T_SOA_DEF,
+    T_SOA_LEN,
+    T_SOA_ELEM,
+    T_SOA_RDEF,
+    T_SOA_VALUE,
+    T_ENTRY_VALUE,
+
+    NUM_TEMPLATES,
+};
+
+typedef struct layout {
+    const char *name;
+    enum tmpl entry; // Definition of `entry__<tag>`
+    enum tmpl def;   // Name of `lookup__<tag>[i]`
+    enum tmpl len;   // Length of the name of `lookup__<tag>[i]`
+    enum tmpl elem;  // Name of a `lookup__<tag>` member `entry`
+    enum tmpl rdef;  // Name of `byvalue__<tag>[i]`
+    enum tmpl value; // Value of `lookup__<tag>[i]`
+} layout;
+
+typedef struct tables {
+    outlist *genned;
+    const str *declared; // Table in declaration order; see `generate_c`
+    usize count;
+    const str *leader;
+    usize max_ident_len;
+    enum options_layout layout;
+    const reverse *rev;
+    const isize *offsets; // Offset of each name in the pool, then its size
+    tmplarg *args;
+} tables;
+
+static u32 choose_index(const enumerator *input, const options *opts);
+static void write_c_options(options *opts, u32 index, outbuf *out);
+static void write_array(outbuf *out, const char *indent, enum tmpl head, tmplarg *args, const isize *vals, usize n);
+static void write_table(const tables *t, outbuf *out);
+static void write_reverse_table(const tables *t, outbuf *out);
+static void write_index_hash(const isize *disp, const isize *slots, usize count, tmplarg *args, outbuf *out);
+static void write_index_switch(const str *names, usize count, tmplarg *args, outbuf *out);
+static void write_index_reverse(const layout *lay, const reverse *rev, tmplarg *args, outbuf *out);
+static void write_switch(const str *names, usize *members, usize n, usize len, int depth, outbuf *out);
+static isize *build_namelens(outlist *genned, usize count, const str *leader);
+static str *build_names(outlist *genned, usize count, const str *leader);
+static isize *build_offsets(outlist *genned, usize count, const str *leader);
+static usize find_sorted(outlist *genned, usize count, const str *name);
+static isize *build_phf(outlist *genned, usize count, const str *leader, isize *disp);
+static reverse *build_reverse(outlist *genned, usize count);
+static u32 phf_hash(u32 seed, const str *leader, const str *name);
+static const char *valuetype(outlist *genned, usize count);
 static int qsort_strcmp(const void *a, const void *b);
 
-static arena *local;
+static _Thread_local arena *local;
+
+// The most members that `--index switch` will build a trie over.
+#define SWITCH_MAX_MEMBERS 4096
 
 // clang-format off
-static const char *e_enum_fmt = "    %-*.*s = %*ld,\n";
-static const char *p_enum_fmt = "#define %-*.*s %*ld\n";
-static const char *e_mask_fmt = "    %-*.*s =  (1 << %*ld),\n";
-static const char *p_mask_fmt = "#define %-*.*s  (1 << %*ld)\n";
-static const char *e_mask_fmt_0 = "    %-*.*s =        %*ld,\n";
-static const char *e_mask_fmt_l = "    %-*.*s = ((1 << %*ld) - 1),\n";
-static const char *p_mask_fmt_0 = "#define %-*.*s        %*ld\n";
-static const char *p_mask_fmt_l = "#define %-*.*s ((1 << %*ld) - 1)\n";
-
-static const char *header_fmt = ""
-    "/*\n"
-    " * %s\n"
-    " * Base command: %s\n"
-    " * Source file: %s\n"
-    " * Program options:\n"
-    "";
-
-static const char *init_guards_fmt = ""
-    " */\n"
-    "\n"
-    "#ifndef %s%s\n"
-    "#define %s%s\n"
-    "\n"
-    "#ifdef __cplusplus\n"
-    "extern \"C\" {\n"
-    "#endif\n"
-    "\n"
-    "#ifdef %sENUM\n"
-    "\n"
-    "enum %s {\n"
-    "";
-
-static const char *lookup_branch_fmt = ""
-    "\n"
-    "#endif /* %sENUM */\n"
-    "\n"
-    "#ifdef %sLOOKUP\n"
-    "\n"
-    "typedef struct entry__%s {\n"
-    "    const long value;\n"
-    "    const char *def;\n"
-    "} entry__%s;\n"
-    "\n"
-    "#ifndef %sLOOKUP_IMPL\n"
-    "\n"
-    "extern const long lengthof__%s;\n"
-    "extern const entry__%s lookup__%s[];\n"
-    "\n"
-    "#else\n"
-    "\n"
-    "const long lengthof__%s = %d;\n"
-    "const entry__%s lookup__%s[] = {\n"
-    "";
-
-static const char *footer_fmt = ""
-    "};\n"
-    "\n"
-    "#endif /* %sLOOKUP_IMPL */\n"
-    "\n"
-    "#endif /* %sLOOKUP */\n"
-    "\n"
-    "#ifdef __cplusplus\n"
-    "}\n"
-    "#endif\n"
-    "\n"
-    "#endif /* %s%s */\n"
-    "";
+// An enumeration member, then the first, inner, and last members of a mask.
+static const entryfmt enum_entries[] = {
+    { " = ",        ",\n" },
+    { " =        ", ",\n" },
+    { " =  (1 << ", "),\n" },
+    { " = ((1 << ", ") - 1),\n" },
+};
+
+static const entryfmt proc_entries[] = {
+    { " ",          "\n" },
+    { "        ",   "\n" },
+    { "  (1 << ",   ")\n" },
+    { " ((1 << ",   ") - 1)\n" },
+};
+
+static const char *const slots[] = {
+    [S_WARNING]      = "warning",
+    [S_MODE]         = "mode",
+    [S_INFILE]       = "infile",
+    [S_GUARD]        = "guard",
+    [S_BASENAME]     = "basename",
+    [S_INCLUDE]      = "include",
+    [S_TAG]          = "tag",
+    [S_COUNT]        = "count",
+    [S_SPAN]         = "span",
+    [S_MIN]          = "min",
+    [S_MAX]          = "max",
+    [S_VALUE_TYPE]   = "value_type",
+    [S_OFFSET_TYPE]  = "offset_type",
+    [S_NAMELEN_TYPE] = "namelen_type",
+    [S_INDEX_TYPE]   = "index_type",
+    [S_DISP_TYPE]    = "disp_type",
+    [S_SLOT_TYPE]    = "slot_type",
+    [S_FUNC]         = "func",
+    [S_DEF]          = "def",
+    [S_LEN]          = "len",
+    [S_ELEM]         = "elem",
+    [S_RDEF]         = "rdef",
+    [S_VALUE]        = "value",
+};
+
+static const char *const srcs[] = {
+    [T_HEADER] = ""
+        "/*\n"
+        " * ${warning}\n"
+        " * Base command: ${mode}\n"
+        " * Source file: ${infile}\n"
+        " * Program options:\n",
+
+    [T_INIT_GUARDS] = ""
+        " */\n"
+        "\n"
+        "#ifndef ${guard}${basename}\n"
+        "#define ${guard}${basename}\n"
+        "\n",
+
+    [T_INCLUDES] = ""
+        "#ifdef ${guard}LOOKUP\n"
+        "#include <stddef.h>\n"
+        "#include <stdint.h>\n"
+        "#include <string.h>\n"
+        "#endif /* ${guard}LOOKUP */\n"
+        "\n",
+
+    [T_INIT_ENUM] = ""
+        "#ifdef __cplusplus\n"
+        "extern \"C\" {\n"
+        "#endif\n"
+        "\n"
+        "#ifdef ${guard}ENUM\n"
+        "\n"
+        "enum ${tag} {\n",
+
+    [T_LOOKUP_BRANCH] = ""
+        "\n"
+        "#endif /* ${guard}ENUM */\n"
+        "\n"
+        "#ifdef ${guard}LOOKUP\n"
+        "\n",
+
+    [T_ENTRY_DEF] = ""
+        "typedef struct entry__${tag} {\n"
+        "    const long value;\n"
+        "    const char *def;\n"
+        "} entry__${tag};\n",
+
+    [T_ENTRY_POOL] = ""
+        "typedef struct entry__${tag} {\n"
+        "    const long value;\n"
+        "    const uint32_t ofs;\n"
+        "    const uint32_t len;\n"
+        "} entry__${tag};\n",
+
+    [T_ENTRY_SOA] = ""
+        "typedef ${value_type} value__${tag};\n"
+        "typedef ${offset_type} offset__${tag};\n",
+
+    [T_LOOKUP_DECLS] = ""
+        "\n"
+        "#ifndef ${guard}LOOKUP_IMPL\n"
+        "\n"
+        "extern const long lengthof__${tag};\n",
+
+    [T_SPLIT_DECLS] = ""
+        "\n"
+        "enum { lengthof__${tag} = ${count} };\n"
+        "\n",
+
+    [T_POOL_DECL]          = "extern const char pool__${tag}[];\n",
+    [T_SOA_DECLS]          = "extern const value__${tag} values__${tag}[];\n"
+                             "extern const offset__${tag} offsets__${tag}[];\n",
+    [T_LOOKUP_DECL]        = "extern const entry__${tag} lookup__${tag}[];\n",
+    [T_NAMELEN_DECL]       = "extern const ${namelen_type} namelen__${tag}[];\n",
+    [T_NAMES_INDEX_DECL]   = "extern const ${index_type} names__${tag}[];\n",
+    [T_BYVALUE_INDEX_DECL] = "extern const ${index_type} byvalue__${tag}[];\n",
+    [T_NAMES_POOL_DECL]    = "extern const uint32_t names__${tag}[];\n",
+    [T_NAMES_DECL]         = "extern const char *const names__${tag}[];\n",
+    [T_BYVALUE_DECL]       = "extern const entry__${tag} byvalue__${tag}[];\n",
+
+    [T_SOURCE_INIT] = ""
+        " */\n"
+        "\n"
+        "#define ${guard}LOOKUP\n"
+        "#include \"${include}\"\n"
+        "\n",
+
+    [T_LOOKUP_IMPL] = ""
+        "\n"
+        "#else\n"
+        "\n"
+        "const long lengthof__${tag} = ${count};\n",
+
+    [T_LOOKUP_TABLE]        = "const entry__${tag} lookup__${tag}[] = {\n",
+    [T_POOL_TABLE]          = "const char pool__${tag}[] = \"\"\n",
+    [T_VALUES_TABLE]        = "const value__${tag} values__${tag}[] = {\n",
+    [T_OFFSETS_ARRAY]       = "const offset__${tag} offsets__${tag}[${span}] = {",
+    [T_NAMELEN_ARRAY]       = "const ${namelen_type} namelen__${tag}[${span}] = {",
+    [T_NAMES_INDEX_ARRAY]   = "const ${index_type} names__${tag}[${span}] = {",
+    [T_BYVALUE_INDEX_ARRAY] = "const ${index_type} byvalue__${tag}[${span}] = {",
+    [T_NAMES_POOL_ARRAY]    = "const uint32_t names__${tag}[${span}] = {",
+    [T_NAMES_TABLE]         = "\nconst char *const names__${tag}[] = {\n",
+    [T_BYVALUE_TABLE]       = "\nconst entry__${tag} byvalue__${tag}[] = {\n",
+
+    [T_TABLE_FOOTER] = ""
+        "\n"
+        "#endif /* ${guard}LOOKUP_IMPL */\n",
+
+    [T_HASH_FUNC] = ""
+        "\n"
+        "static inline uint32_t hash__${tag}(uint32_t seed, const char *s, size_t len)\n"
+        "{\n"
+        "    uint32_t h = seed ^ 2166136261u;\n"
+        "    for (size_t i = 0; i < len; i++) {\n"
+        "        h = (h ^ (unsigned char)s[i]) * 16777619u;\n"
+        "    }\n"
+        "\n"
+        "    h ^= h >> 16;\n"
+        "    h *= 0x85ebca6bu;\n"
+        "    h ^= h >> 13;\n"
+        "    h *= 0xc2b2ae35u;\n"
+        "    h ^= h >> 16;\n"
+        "    return h;\n"
+        "}\n"
+        "\n"
+        "/* Return the position in the lookup table of the entry named by s[0..len),\n"
+        " * or -1. */\n"
+        "static inline long find__${tag}(const char *s, size_t len)\n"
+        "{\n",
+
+    [T_DISP_ARRAY] = "static const ${disp_type} disp[${span}] = {",
+    [T_SLOT_ARRAY] = "static const ${slot_type} slot[${span}] = {",
+
+    [T_FIND_BODY] = ""
+        "\n"
+        "    long d = disp[hash__${tag}(0, s, len) % ${count}u];\n"
+        "    long i = slot[d < 0 ? -d - 1 : (long)(hash__${tag}((uint32_t)d, s, len) % ${count}u)];\n"
+        "    return ${len} == len && memcmp(${def}, s, len) == 0 ? i : -1;\n"
+        "}\n",
+
+    [T_BSEARCH_FUNC] = ""
+        "\n"
+        "/* Compare a NUL-terminated name against an entry of the lookup table, which\n"
+        " * is sorted by name; suitable for use with bsearch. */\n"
+        "static inline int compare__${tag}(const void *key, const void *entry)\n"
+        "{\n"
+        "    return strcmp((const char *)key, ${elem});\n"
+        "}\n"
+        "\n"
+        "static inline int namecmp__${tag}(long i, const char *s, size_t len)\n"
+        "{\n"
+        "    size_t n = ${len};\n"
+        "    int c = memcmp(${def}, s, n < len ? n : len);\n"
+        "    return c != 0 ? c : (n > len) - (n < len);\n"
+        "}\n"
+        "\n"
+        "/* Return the position in the lookup table of the entry named by s[0..len),\n"
+        " * or -1. */\n"
+        "static inline long lookup_by_name__${tag}(const char *s, size_t len)\n"
+        "{\n"
+        "    long i = 0;\n"
+        "    for (long n = ${count}; n > 1; n -= n / 2) {\n"
+        "        i = namecmp__${tag}(i + n / 2, s, len) < 0 ? i + n / 2 : i;\n"
+        "    }\n"
+        "\n"
+        "    i += namecmp__${tag}(i, s, len) < 0;\n"
+        "    return i < ${count} && namecmp__${tag}(i, s, len) == 0 ? i : -1;\n"
+        "}\n",
+
+    [T_SWITCH_FUNC] = ""
+        "\n"
+        "/* Return the position in the lookup table of the entry named by s[0..len),\n"
+        " * or -1. */\n"
+        "static inline long match__${tag}(const char *s, size_t len)\n"
+        "{\n"
+        "    switch (len) {\n",
+
+    [T_SWITCH_FOOTER] = ""
+        "    }\n"
+        "\n"
+        "    return -1;\n"
+        "}\n",
+
+    [T_PARSE_FUNC] = ""
+        "\n"
+        "/* Parse the name s[0..len), which need not be NUL-terminated, into its value.\n"
+        " * Return 1 on success, or 0 if no entry has that name. */\n"
+        "static inline int parse__${tag}(const char *s, size_t len, long *value)\n"
+        "{\n"
+        "    long i = ${func}__${tag}(s, len);\n"
+        "    if (i < 0) {\n"
+        "        return 0;\n"
+        "    }\n"
+        "\n"
+        "    *value = ${value};\n"
+        "    return 1;\n"
+        "}\n",
+
+    [T_REVERSE_DENSE] = ""
+        "\n"
+        "static const long minof__${tag} = ${min};\n"
+        "static const long maxof__${tag} = ${max};\n"
+        "\n"
+        "/* Return the name of the first entry declared with the given value, or NULL. */\n"
+        "static inline const char *name_of__${tag}(long value)\n"
+        "{\n"
+        "    return value >= minof__${tag} && value <= maxof__${tag} ? names__${tag}[value - minof__${tag}] : NULL;\n"
+        "}\n",
+
+    [T_REVERSE_POOL] = ""
+        "\n"
+        "static const long minof__${tag} = ${min};\n"
+        "static const long maxof__${tag} = ${max};\n"
+        "\n"
+        "/* Return the name of the first entry declared with the given value, or NULL. */\n"
+        "static inline const char *name_of__${tag}(long value)\n"
+        "{\n"
+        "    uint32_t ofs = value >= minof__${tag} && value <= maxof__${tag} ? names__${tag}[value - minof__${tag}] : UINT32_MAX;\n"
+        "    return ofs != UINT32_MAX ? pool__${tag} + ofs : NULL;\n"
+        "}\n",
+
+    [T_REVERSE_SOA] = ""
+        "\n"
+        "static const long minof__${tag} = ${min};\n"
+        "static const long maxof__${tag} = ${max};\n"
+        "\n"
+        "/* Return the name of the first entry declared with the given value, or NULL. */\n"
+        "static inline const char *name_of__${tag}(long value)\n"
+        "{\n"
+        "    long i = value >= minof__${tag} && value <= maxof__${tag} ? names__${tag}[value - minof__${tag}] : -1;\n"
+        "    return i >= 0 ? pool__${tag} + offsets__${tag}[i] : NULL;\n"
+        "}\n",
+
+    [T_REVERSE_SPARSE] = ""
+        "\n"
+        "static const long minof__${tag} = ${min};\n"
+        "static const long maxof__${tag} = ${max};\n"
+        "\n"
+        "/* Return the name of the first entry declared with the given value, or NULL. */\n"
+        "static inline const char *name_of__${tag}(long value)\n"
+        "{\n"
+        "    long i = 0;\n"
+        "    for (long n = ${span}; n > 1; n -= n / 2) {\n"
+        "        i = byvalue__${tag}[i + n / 2].value < value ? i + n / 2 : i;\n"
+        "    }\n"
+        "\n"
+        "    i += byvalue__${tag}[i].value < value;\n"
+        "    return i < ${span} && byvalue__${tag}[i].value == value ? ${rdef} : NULL;\n"
+        "}\n",
+
+    [T_REVERSE_SPARSE_SOA] = ""
+        "\n"
+        "static const long minof__${tag} = ${min};\n"
+        "static const long maxof__${tag} = ${max};\n"
+        "\n"
+        "/* Return the name of the first entry declared with the given value, or NULL. */\n"
+        "static inline const char *name_of__${tag}(long value)\n"
+        "{\n"
+        "    long i = 0;\n"
+        "    for (long n = ${span}; n > 1; n -= n / 2) {\n"
+        "        i = (long)values__${tag}[byvalue__${tag}[i + n / 2]] < value ? i + n / 2 : i;\n"
+        "    }\n"
+        "\n"
+        "    i += (long)values__${tag}[byvalue__${tag}[i]] < value;\n"
+        "    return i < ${span} && (long)values__${tag}[byvalue__${tag}[i]] == value ? ${rdef} : NULL;\n"
+        "}\n",
+
+    [T_FOOTER] = ""
+        "\n"
+        "#endif /* ${guard}LOOKUP */\n"
+        "\n"
+        "#ifdef __cplusplus\n"
+        "}\n"
+        "#endif\n"
+        "\n"
+        "#endif /* ${guard}${basename} */\n",
+
+    [T_AOS_DEF]     = "lookup__${tag}[i].def",
+    [T_AOS_LEN]     = "namelen__${tag}[i]",
+    [T_AOS_ELEM]    = "((const entry__${tag} *)entry)->def",
+    [T_AOS_RDEF]    = "byvalue__${tag}[i].def",
+    [T_POOL_DEF]    = "pool__${tag} + lookup__${tag}[i].ofs",
+    [T_POOL_LEN]    = "lookup__${tag}[i].len",
+    [T_POOL_ELEM]   = "pool__${tag} + ((const entry__${tag} *)entry)->ofs",
+    [T_POOL_RDEF]   = "pool__${tag} + byvalue__${tag}[i].ofs",
+    [T_SOA_DEF]     = "pool__${tag} + offsets__${tag}[i]",
+    [T_SOA_LEN]     = "(size_t)(offsets__${tag}[i + 1] - offsets__${tag}[i] - 1)",
+    [T_SOA_ELEM]    = "pool__${tag} + *(const offset__${tag} *)entry",
+    [T_SOA_RDEF]    = "pool__${tag} + offsets__${tag}[byvalue__${tag}[i]]",
+    [T_SOA_VALUE]   = "values__${tag}[i]",
+    [T_ENTRY_VALUE] = "lookup__${tag}[i].value",
+};
+
+static const layout layouts[] = {
+    [OPTS_T_AOS] = {
+        .name = "aos",
+        .entry = T_ENTRY_DEF,
+        .def = T_AOS_DEF,
+        .len = T_AOS_LEN,
+        .elem = T_AOS_ELEM,
+        .rdef = T_AOS_RDEF,
+        .value = T_ENTRY_VALUE,
+    },
+    [OPTS_T_POOL] = {
+        .name = "pool",
+        .entry = T_ENTRY_POOL,
+        .def = T_POOL_DEF,
+        .len = T_POOL_LEN,
+        .elem = T_POOL_ELEM,
+        .rdef = T_POOL_RDEF,
+        .value = T_ENTRY_VALUE,
+    },
+    [OPTS_T_SOA] = {
+        .name = "soa",
+        .entry = T_ENTRY_SOA,
+        .def = T_SOA_DEF,
+        .len = T_SOA_LEN,
+        .elem = T_SOA_ELEM,
+        .rdef = T_SOA_RDEF,
+        .value = T_SOA_VALUE,
+    },
+};
 // clang-format on
 
-bool generate_c(enumerator *input, options *opts, FILE *fout)
+static template compiled[NUM_TEMPLATES];
+
+tmplset c_templates = {
+    .srcs = srcs,
+    .count = NUM_TEMPLATES,
+    .slots = slots,
+    .nslots = NUM_SLOTS,
+    .compiled = compiled,
+};
+
+static inline void render(outbuf *out, enum tmpl t, const tmplarg *args)
 {
-    if (input == NULL || fout == NULL) {
+    tmplrender(out, &compiled[t], args);
+}
+
+bool generate_c(enumerator *input, options *opts, arena *a, const outdest *out)
+{
+    if (input == NULL || input->count == 0 || out == NULL) {
         return false;
     }
 
-    arena a = arena_new(1 << 16);
-    local = &a;
+    const u32 index = choose_index(input, opts);
+
+    // When splitting, the tables are written to their own source file, which
+    // is compiled once; the header keeps only their declarations.
+    bool split = opts->srcfile.len > 0;
+
+    scratch s;
+    scratch_begin(&s, a);
+    local = a;
     if (setjmp(local->env)) {
-        free(local->mem);
+        scratch_end(&s);
         return false;
     }
 
-    str leader = make_prefix(&opts->leader);
-    str guardp = make_prefix(&opts->guard);
-    str foutbn = make_basename(&opts->outfile);
+    str leader = make_prefix(local, &opts->leader);
+    str guardp = make_prefix(local, &opts->guard);
+    str foutbn = make_basename(local, &opts->outfile);
 
-    outlist *genned = stringify(input, &leader, opts->mode);
-    qsort(genned->table, input->count, sizeof(str), qsort_strcmp);
+    outlist *genned = stringify(local, input, &strZ, opts->mode);
 
-    fprintf(fout, header_fmt,
-            header_warning.buf,
-            opts->mode & OPTS_M_ENUM ? "enum" : "mask",
-            opts->infile.buf);
+    // Sorting the table loses declaration order, which is needed for indexing
+    // by value.
+    str *declared = NULL;
+    reverse *rev = NULL;
+    if (index & OPTS_I_REVERSE) {
+        declared = new (local, str, input->count, A_F_EXTEND);
+        memcpy(declared, genned->table, input->count * sizeof(str));
+        rev = build_reverse(genned, input->count);
+    }
 
-    write_options(opts, fout);
+    strsort(genned->table, input->count, opts->threads);
 
-    fprintf(fout, init_guards_fmt,
-            guardp.buf, foutbn.buf,
-            guardp.buf, foutbn.buf,
-            guardp.buf,
-            opts->tag.buf);
+    // Indexes cannot discriminate between identical keys, so reject them now,
+    // before anything has been written.
+    for (usize i = 1; (index & OPTS_I_BY_NAME) && i < input->count; i++) {
+        if (streq(&genned->table[i - 1], &genned->table[i])) {
+            fprintf(stderr,
+                    "metang: Duplicate identifier “%s” cannot be indexed\n",
+                    genned->table[i].buf);
+            longjmp(local->env, 1);
+        }
+    }
 
-    strlist *e_curr = genned->enums;
-    for (; e_curr; e_curr = e_curr->next) {
-        fwrite(e_curr->elem.buf, 1, e_curr->elem.len, fout);
+    const layout *lay = &layouts[opts->layout];
+    bool has_namelens = (index & (OPTS_I_HASH | OPTS_I_BSEARCH)) && opts->layout == OPTS_T_AOS;
+
+    isize *namelens = NULL;
+    if (has_namelens) {
+        namelens = build_namelens(genned, input->count, &leader);
+    }
+
+    isize *offsets = NULL;
+    if (opts->layout != OPTS_T_AOS) {
+        offsets = build_offsets(genned, input->count, &leader);
     }
 
-    fprintf(fout, "};\n\n#else\n\n");
+    const char *func = (index & OPTS_I_HASH) ? "find"
+        : (index & OPTS_I_SWITCH)            ? "match"
+                                                   : "lookup_by_name";
 
-    strlist *p_curr = genned->procs;
-    for (; p_curr; p_curr = p_curr->next) {
-        fwrite(p_curr->elem.buf, 1, p_curr->elem.len, fout);
+    tmplarg args[NUM_SLOTS] = {
+        [S_WARNING] = TSTR(header_warning.buf),
+        [S_MODE] = TSTR(opts->mode & OPTS_M_ENUM ? "enum" : "mask"),
+        [S_INFILE] = TSTR(opts->infile.buf),
+        [S_GUARD] = TSTR(guardp.buf),
+        [S_BASENAME] = TSTR(foutbn.buf),
+        [S_INCLUDE] = TSTR(strrcut(&opts->outfile, '/').tail.buf),
+        [S_TAG] = TSTR(opts->tag.buf),
+        [S_COUNT] = TINT(input->count),
+        [S_VALUE_TYPE] = TSTR(valuetype(genned, input->count)),
+        [S_OFFSET_TYPE] = TSTR(offsets ? inttype(0, offsets[input->count]) : ""),
+        [S_NAMELEN_TYPE] = TSTR(inttype(0, leader.len + input->max_ident_len)),
+        [S_INDEX_TYPE] = TSTR(rev ? inttype(rev->dense ? -1 : 0, input->count - 1) : ""),
+        [S_FUNC] = TSTR(func),
+        [S_DEF] = TTMPL(&compiled[lay->def]),
+        [S_LEN] = TTMPL(&compiled[lay->len]),
+        [S_ELEM] = TTMPL(&compiled[lay->elem]),
+        [S_RDEF] = TTMPL(&compiled[lay->rdef]),
+        [S_VALUE] = TTMPL(&compiled[lay->value]),
+    };
+
+    tables t = {
+        .genned = genned,
+        .declared = declared,
+        .count = input->count,
+        .leader = &leader,
+        .max_ident_len = input->max_ident_len,
+        .layout = opts->layout,
+        .rev = rev,
+        .offsets = offsets,
+        .args = args,
+    };
+
+    isize *disp = NULL;
+    isize *slots = NULL;
+    if (index & OPTS_I_HASH) {
+        disp = new (local, isize, input->count, A_F_ZERO | A_F_EXTEND);
+        slots = build_phf(genned, input->count, &leader, disp);
     }
 
-    fprintf(fout, lookup_branch_fmt,
-            guardp.buf,                    // "#endif /* %sENUM */\n"
-            guardp.buf,                    // "#ifdef %sLOOKUP\n"
-            opts->tag.buf,                 // "typedef struct entry__%s {\n"
-            opts->tag.buf,                 // "} entry__%s;\n"
-            guardp.buf,                    // "#ifndef %sLOOKUP_IMPL\n"
-            opts->tag.buf,                 // "extern const long lengthof__%s;\n"
-            opts->tag.buf, opts->tag.buf,  // "extern const entry__%s lookup__%s[];\n"
-            opts->tag.buf, input->count,   // "const long lengthof__%s = %d;\n"
-            opts->tag.buf, opts->tag.buf); // "const entry__%s lookup__%s[] = {\n"
+    outbuf ob = obnew(local, 1 << 16);
+    render(&ob, T_HEADER, args);
+    write_c_options(opts, index, &ob);
+    render(&ob, T_INIT_GUARDS, args);
 
-    for (usize i = 0; i < input->count; i++) {
-        usize padding = input->max_ident_len - genned->table[i].len + 1;
-        fprintf(fout,
-                "    { %.*s%s,%*c\"%.*s%s\",%*c},\n",
-                (int)leader.len, leader.buf, genned->table[i].buf,
-                (int)padding, ' ',
-                (int)leader.len, leader.buf, genned->table[i].buf,
-                (int)padding, ' ');
+    if (index || opts->layout != OPTS_T_AOS) {
+        render(&ob, T_INCLUDES, args);
     }
 
-    fprintf(fout, footer_fmt,
-            guardp.buf,
-            guardp.buf,
-            guardp.buf, foutbn.buf);
+    render(&ob, T_INIT_ENUM, args);
+    write_members(input, &leader, opts->mode, enum_entries, "    ", &ob);
+    obputs(&ob, "};\n\n#else\n\n");
+    write_members(input, &leader, opts->mode, proc_entries, "#define ", &ob);
+
+    render(&ob, T_LOOKUP_BRANCH, args);
+    render(&ob, lay->entry, args);
+    render(&ob, split ? T_SPLIT_DECLS : T_LOOKUP_DECLS, args);
 
-    free(local->mem);
-    return true;
+    if (opts->layout != OPTS_T_AOS) {
+        render(&ob, T_POOL_DECL, args);
+    }
+
+    render(&ob, opts->layout == OPTS_T_SOA ? T_SOA_DECLS : T_LOOKUP_DECL, args);
+
+    if (has_namelens) {
+        render(&ob, T_NAMELEN_DECL, args);
+    }
+
+    if (rev && opts->layout == OPTS_T_SOA) {
+        render(&ob, rev->dense ? T_NAMES_INDEX_DECL : T_BYVALUE_INDEX_DECL, args);
+    } else if (rev && rev->dense && opts->layout == OPTS_T_POOL) {
+        render(&ob, T_NAMES_POOL_DECL, args);
+    } else if (rev && rev->dense) {
+        render(&ob, T_NAMES_DECL, args);
+    } else if (rev) {
+        render(&ob, T_BYVALUE_DECL, args);
+    }
+
+    outbuf src = { 0 };
+    outbuf *tab = &ob;
+    if (split) {
+        src = obnew(local, 1 << 16);
+        render(&src, T_HEADER, args);
+        write_c_options(opts, index, &src);
+        render(&src, T_SOURCE_INIT, args);
+        tab = &src;
+    } else {
+        render(&ob, T_LOOKUP_IMPL, args);
+    }
+
+    write_table(&t, tab);
+
+    if (has_namelens) {
+        obputs(tab, "\n");
+        write_array(tab, "", T_NAMELEN_ARRAY, args, namelens, input->count);
+    }
+
+    if (rev) {
+        write_reverse_table(&t, tab);
+    }
+
+    if (!split) {
+        render(&ob, T_TABLE_FOOTER, args);
+    }
+
+    if (index & OPTS_I_HASH) {
+        write_index_hash(disp, slots, input->count, args, &ob);
+    }
+
+    if (index & OPTS_I_BSEARCH) {
+        render(&ob, T_BSEARCH_FUNC, args);
+    }
+
+    if (index & OPTS_I_SWITCH) {
+        str *names = build_names(genned, input->count, &leader);
+        write_index_switch(names, input->count, args, &ob);
+    }
+
+    if (index & OPTS_I_BY_NAME) {
+        render(&ob, T_PARSE_FUNC, args);
+    }
+
+    if (index & OPTS_I_REVERSE) {
+        write_index_reverse(lay, rev, args, &ob);
+    }
+
+    render(&ob, T_FOOTER, args);
+
+    // The source is written first, so that a header is never newer than the
+    // tables that it declares.
+    const outdest *srcout = out->source ? out->source : &(outdest){ .path = opts->srcfile.buf };
+    bool ok = !split || obcommit(&src, srcout);
+    ok = obcommit(&ob, out) && ok;
+
+    scratch_end(&s);
+    return ok;
 }
 
-static inline char *stringify_entry(
-    const str *leader,
-    usize symbol_len,
-    usize assign_len,
-    usize column_len,
-    usize entry_len,
-    isize assignment,
-    const char *fmt)
+// Compilers take minutes over a switch trie of more than `SWITCH_MAX_MEMBERS`,
+// so these are indexed by binary search instead, unless a hash is already
+// given. The options are left as given, as they may be reused for other
+// targets.
+static u32 choose_index(const enumerator *input, const options *opts)
 {
-    char *entry = new (local, char, entry_len + 1, A_F_ZERO | A_F_EXTEND);
-    snprintf(entry,
-             entry_len + 1,
-             fmt,
-             column_len,
-             (int)symbol_len, leader->buf,
-             (int)assign_len, assignment);
-    return entry;
+    u32 index = opts->index;
+    if ((index & OPTS_I_SWITCH) && input->count > SWITCH_MAX_MEMBERS) {
+        fprintf(stderr,
+                "metang: warning: %zu members are too many to index by switch; using bsearch\n",
+                input->count);
+        index &= ~OPTS_I_SWITCH;
+        if (!(index & OPTS_I_HASH)) {
+            index |= OPTS_I_BSEARCH;
+        }
+    }
+
+    return index;
 }
 
-static outlist *stringify(enumerator *input, const str *leader, enum options_mode mode)
+static void write_c_options(options *opts, u32 index, outbuf *out)
 {
-    outlist *outputs = new (local, outlist, 1, A_F_ZERO | A_F_EXTEND);
-    outputs->enums = NULL;
-    outputs->procs = NULL;
-    outputs->table = new (local, str, input->count, A_F_ZERO | A_F_EXTEND);
+    write_options(opts, " *   ", out);
 
-    if (mode == OPTS_M_ENUM) {
-        stringify_enumeration(input, leader, outputs, input->max_ident_len + leader->len);
-    } else {
-        stringify_bitmask(input, leader, outputs, input->max_ident_len + leader->len);
+    if (index & OPTS_I_HASH) {
+        obputs(out, " *   --index hash\n");
+    }
+
+    if (index & OPTS_I_BSEARCH) {
+        obputs(out, " *   --index bsearch\n");
+    }
+
+    if (index & OPTS_I_REVERSE) {
+        obputs(out, " *   --index reverse\n");
+    }
+
+    if (index & OPTS_I_SWITCH) {
+        obputs(out, " *   --index switch\n");
+    }
+
+    if (opts->layout != OPTS_T_AOS) {
+        obputs(out, " *   --layout ");
+        obputs(out, layouts[opts->layout].name);
+        obputs(out, "\n");
+    }
+
+    if (opts->srcfile.len > 0) {
+        obputs(out, " *   --source ");
+        obstr(out, &opts->srcfile);
+        obputs(out, "\n");
+    }
+
+    write_input_options(opts, " *   ", out);
+}
+
+// The declaration `head` is rendered with its span set to `n`.
+static void write_array(outbuf *out, const char *indent, enum tmpl head, tmplarg *args, const isize *vals, usize n)
+{
+    usize width = 1;
+    for (usize i = 0; i < n; i++) {
+        usize w = intlen(vals[i]);
+        width = w > width ? w : width;
+    }
+
+    // Pack as many columns onto a line as will fit in 80 characters.
+    usize columns = (80 - strlen(indent) - 4) / (width + 2);
+    columns = columns == 0 ? 1 : columns;
+
+    args[S_SPAN] = TINT(n);
+    obputs(out, indent);
+    render(out, head, args);
+    for (usize i = 0; i < n; i++) {
+        if (i % columns == 0) {
+            obputs(out, "\n");
+            obputs(out, indent);
+            obputs(out, "   ");
+        }
+
+        obputs(out, " ");
+        obint(out, vals[i], width);
+        obputs(out, ",");
+    }
+    obputs(out, "\n");
+    obputs(out, indent);
+    obputs(out, "};\n");
+}
+
+static void write_table(const tables *t, outbuf *out)
+{
+    const str *table = t->genned->table;
+    const str *leader = t->leader;
+
+    if (t->layout == OPTS_T_AOS) {
+        render(out, T_LOOKUP_TABLE, t->args);
+        for (usize i = 0; i < t->count; i++) {
+            usize padding = t->max_ident_len - table[i].len + 1;
+            obputs(out, "    { ");
+            obstr(out, leader);
+            obstr(out, &table[i]);
+            obputs(out, ",");
+            obpad(out, ' ', padding);
+            obputs(out, "\"");
+            obstr(out, leader);
+            obstr(out, &table[i]);
+            obputs(out, "\",");
+            obpad(out, ' ', padding);
+            obputs(out, "},\n");
+        }
+        obputs(out, "};\n");
+        return;
+    }
+
+    render(out, T_POOL_TABLE, t->args);
+    for (usize i = 0; i < t->count; i++) {
+        obputs(out, "    \"");
+        obstr(out, leader);
+        obstr(out, &table[i]);
+        obputs(out, "\\0\"\n");
     }
+    obputs(out, "    \"\";\n\n");
 
-    return outputs;
+    if (t->layout == OPTS_T_SOA) {
+        render(out, T_VALUES_TABLE, t->args);
+        for (usize i = 0; i < t->count; i++) {
+            obputs(out, "    ");
+            obstr(out, leader);
+            obstr(out, &table[i]);
+            obputs(out, ",\n");
+        }
+        obputs(out, "};\n\n");
+        write_array(out, "", T_OFFSETS_ARRAY, t->args, t->offsets, t->count + 1);
+        return;
+    }
+
+    usize ofs_width = intlen(t->offsets[t->count]);
+    usize len_width = intlen(leader->len + t->max_ident_len);
+    render(out, T_LOOKUP_TABLE, t->args);
+    for (usize i = 0; i < t->count; i++) {
+        usize padding = t->max_ident_len - table[i].len + 1;
+        obputs(out, "    { ");
+        obstr(out, leader);
+        obstr(out, &table[i]);
+        obputs(out, ",");
+        obpad(out, ' ', padding);
+        obint(out, t->offsets[i], ofs_width);
+        obputs(out, ", ");
+        obint(out, leader->len + table[i].len, len_width);
+        obputs(out, ", },\n");
+    }
+    obputs(out, "};\n");
 }
 
-static void stringify_enumeration(enumerator *input, const str *leader, outlist *outputs, usize max_ident_len)
+static void write_reverse_table(const tables *t, outbuf *out)
 {
-    usize enum_entry_len_base = max_ident_len + 9;
-    usize proc_entry_len_base = max_ident_len + 10;
-    usize assign_len = input->max_assign_len;
-    char *bufp = leader->buf + leader->len;
-
-    strlist **e_tail = &outputs->enums;
-    strlist **p_tail = &outputs->procs;
-    enumerator *curr = input;
-
-    for (usize i = 0; curr; curr = curr->next, i++) {
-        str cased_elem = strsnake(&curr->ident, bufp, NULL, S_SNAKE_F_UPPER);
-        usize symbol_len = leader->len + cased_elem.len;
-
-        char *claimed_elem = claim(local, cased_elem.buf, cased_elem.len + 1, A_F_ZERO | A_F_EXTEND);
-        outputs->table[i] = strnew(claimed_elem, strlen(claimed_elem));
-
-        // Format an enum entry: '    ' -> symbol -> ' = ' -> assignment + ',\n'
-        char *enum_entry = stringify_entry(leader,
-                                           symbol_len,
-                                           assign_len,
-                                           max_ident_len,
-                                           enum_entry_len_base + assign_len,
-                                           curr->assignment,
-                                           e_enum_fmt);
-        strlist_append(e_tail, local, strnew(enum_entry, strlen(enum_entry)), A_F_EXTEND);
-
-        // Format a preproc entry: '#define ' -> symbol -> ' ' -> assignment + '\n'
-        char *proc_entry = stringify_entry(leader,
-                                           symbol_len,
-                                           assign_len,
-                                           max_ident_len,
-                                           proc_entry_len_base + assign_len,
-                                           curr->assignment,
-                                           p_enum_fmt);
-        strlist_append(p_tail, local, strnew(proc_entry, strlen(proc_entry)), A_F_EXTEND);
+    const reverse *rev = t->rev;
+    const str *leader = t->leader;
+
+    // Struct-of-arrays tables refer to each name by its position in the
+    // lookup table.
+    if (t->layout == OPTS_T_SOA) {
+        isize *positions = new (local, isize, rev->span, A_F_EXTEND);
+        for (usize i = 0; i < rev->span; i++) {
+            positions[i] = rev->order[i] < 0
+                ? -1
+                : (isize)find_sorted(t->genned, t->count, &t->declared[rev->order[i]]);
+        }
+
+        obputs(out, "\n");
+        write_array(out, "", rev->dense ? T_NAMES_INDEX_ARRAY : T_BYVALUE_INDEX_ARRAY, t->args, positions, rev->span);
+        return;
     }
+
+    if (rev->dense && t->offsets) {
+        isize *names = new (local, isize, rev->span, A_F_EXTEND);
+        for (usize i = 0; i < rev->span; i++) {
+            names[i] = rev->order[i] < 0
+                ? UINT32_MAX
+                : t->offsets[find_sorted(t->genned, t->count, &t->declared[rev->order[i]])];
+        }
+
+        obputs(out, "\n");
+        write_array(out, "", T_NAMES_POOL_ARRAY, t->args, names, rev->span);
+        return;
+    }
+
+    if (rev->dense) {
+        render(out, T_NAMES_TABLE, t->args);
+        for (usize i = 0; i < rev->span; i++) {
+            if (rev->order[i] < 0) {
+                obputs(out, "    NULL,\n");
+            } else {
+                obputs(out, "    \"");
+                obstr(out, leader);
+                obstr(out, &t->declared[rev->order[i]]);
+                obputs(out, "\",\n");
+            }
+        }
+        obputs(out, "};\n");
+        return;
+    }
+
+    usize ofs_width = t->offsets ? intlen(t->offsets[t->count]) : 0;
+    usize len_width = intlen(leader->len + t->max_ident_len);
+    render(out, T_BYVALUE_TABLE, t->args);
+    for (usize i = 0; i < rev->span; i++) {
+        const str *name = &t->declared[rev->order[i]];
+        usize padding = t->max_ident_len - name->len + 1;
+        obputs(out, "    { ");
+        obstr(out, leader);
+        obstr(out, name);
+        obputs(out, ",");
+        obpad(out, ' ', padding);
+
+        if (t->offsets) {
+            obint(out, t->offsets[find_sorted(t->genned, t->count, name)], ofs_width);
+            obputs(out, ", ");
+            obint(out, leader->len + name->len, len_width);
+            obputs(out, ", },\n");
+        } else {
+            obputs(out, "\"");
+            obstr(out, leader);
+            obstr(out, name);
+            obputs(out, "\",");
+            obpad(out, ' ', padding);
+            obputs(out, "},\n");
+        }
+    }
+    obputs(out, "};\n");
 }
 
-static void stringify_bitmask(enumerator *input, const str *leader, outlist *outputs, usize max_ident_len)
+static void write_index_hash(const isize *disp, const isize *slots, usize count, tmplarg *args, outbuf *out)
 {
-    usize enum_entry_len_base = max_ident_len + 17;
-    usize proc_entry_len_base = max_ident_len + 18;
-    usize assign_len = input->max_assign_len;
-    char *bufp = leader->buf + leader->len;
-
-    strlist **e_tail = &outputs->enums;
-    strlist **p_tail = &outputs->procs;
-    enumerator *curr = input;
-
-    for (usize i = 0; curr; curr = curr->next, i++) {
-        str cased_elem = strsnake(&curr->ident, bufp, NULL, S_SNAKE_F_UPPER);
-        usize symbol_len = leader->len + cased_elem.len;
-
-        char *claimed_elem = claim(local, cased_elem.buf, cased_elem.len + 1, A_F_ZERO | A_F_EXTEND);
-        outputs->table[i] = strnew(claimed_elem, strlen(claimed_elem));
-
-        const char *e_fmt = e_mask_fmt;
-        const char *p_fmt = p_mask_fmt;
-        usize assignment = curr->assignment;
-        if (i == 0) { // first element
-            e_fmt = e_mask_fmt_0;
-            p_fmt = p_mask_fmt_0;
-            assignment = 1;              // gets set to 0 by the subtraction below
-        } else if (curr->next == NULL) { // last element
-            e_fmt = e_mask_fmt_l;
-            p_fmt = p_mask_fmt_l;
-            enum_entry_len_base += 5;
-            proc_entry_len_base += 5;
+    isize dmin = 0;
+    isize dmax = 0;
+    for (usize i = 0; i < count; i++) {
+        dmin = disp[i] < dmin ? disp[i] : dmin;
+        dmax = disp[i] > dmax ? disp[i] : dmax;
+    }
+
+    args[S_DISP_TYPE] = TSTR(inttype(dmin, dmax));
+    args[S_SLOT_TYPE] = TSTR(inttype(0, count - 1));
+
+    render(out, T_HASH_FUNC, args);
+    write_array(out, "    ", T_DISP_ARRAY, args, disp, count);
+    write_array(out, "    ", T_SLOT_ARRAY, args, slots, count);
+    render(out, T_FIND_BODY, args);
+}
+
+static void write_index_reverse(const layout *lay, const reverse *rev, tmplarg *args, outbuf *out)
+{
+    args[S_MIN] = TINT(rev->min);
+    args[S_MAX] = TINT(rev->max);
+    args[S_SPAN] = TINT(rev->span);
+
+    if (rev->dense) {
+        render(out,
+               lay == &layouts[OPTS_T_SOA]    ? T_REVERSE_SOA
+                   : lay == &layouts[OPTS_T_POOL] ? T_REVERSE_POOL
+                                                  : T_REVERSE_DENSE,
+               args);
+    } else {
+        render(out, lay == &layouts[OPTS_T_SOA] ? T_REVERSE_SPARSE_SOA : T_REVERSE_SPARSE, args);
+    }
+}
+
+static void write_index_switch(const str *names, usize count, tmplarg *args, outbuf *out)
+{
+    usize *members = new (local, usize, count, A_F_EXTEND);
+
+    render(out, T_SWITCH_FUNC, args);
+
+    // Visit each distinct length in ascending order.
+    for (usize prev = 0;;) {
+        usize len = 0;
+        for (usize i = 0; i < count; i++) {
+            if (names[i].len > prev && (len == 0 || names[i].len < len)) {
+                len = names[i].len;
+            }
         }
 
-        // Format an enum entry: '    ' -> symbol -> ' = ' -> assignment + ',\n'
-        char *enum_entry = stringify_entry(leader,
-                                           symbol_len,
-                                           assign_len,
-                                           max_ident_len,
-                                           enum_entry_len_base + assign_len,
-                                           assignment - 1,
-                                           e_fmt);
-        strlist_append(e_tail, local, strnew(enum_entry, strlen(enum_entry)), A_F_EXTEND);
-
-        // Format a preproc entry: '#define ' -> symbol -> ' ' -> assignment + '\n'
-        char *proc_entry = stringify_entry(leader,
-                                           symbol_len,
-                                           assign_len,
-                                           max_ident_len,
-                                           proc_entry_len_base + assign_len,
-                                           assignment - 1,
-                                           p_fmt);
-        strlist_append(p_tail, local, strnew(proc_entry, strlen(proc_entry)), A_F_EXTEND);
+        if (len == 0) {
+            break;
+        }
+
+        usize n = 0;
+        for (usize i = 0; i < count; i++) {
+            if (names[i].len == len) {
+                members[n++] = i;
+            }
+        }
+
+        obputs(out, "    case ");
+        obint(out, len, 0);
+        obputs(out, ":\n");
+        write_switch(names, members, n, len, 2, out);
+        prev = len;
     }
+    render(out, T_SWITCH_FOOTER, args);
 }
 
-static void write_options(options *opts, FILE *fout)
+// Write a matcher for the `n` names in `members`, all of length `len`. Each
+// level of the trie switches on the character position which best divides the
+// remaining names, until only one name is left to compare in full.
+static void write_switch(const str *names, usize *members, usize n, usize len, int depth, outbuf *out)
 {
-    if (opts->set_leader) {
-        fprintf(fout, " *   --leader %s\n", opts->leader.buf);
+    int indent = depth * 4;
+    if (n == 1) {
+        obpad(out, ' ', indent);
+        obputs(out, "return memcmp(s, \"");
+        obstr(out, &names[members[0]]);
+        obputs(out, "\", ");
+        obint(out, len, 0);
+        obputs(out, ") == 0 ? ");
+        obint(out, members[0], 0);
+        obputs(out, " : -1;\n");
+        return;
     }
 
-    if (opts->set_tag) {
-        fprintf(fout, " *   --tag-name %s\n", opts->tag.buf);
+    usize pos = 0;
+    usize best = 0;
+    for (usize p = 0; p < len; p++) {
+        bool seen[256] = { 0 };
+        usize distinct = 0;
+        for (usize i = 0; i < n; i++) {
+            unsigned char c = names[members[i]].buf[p];
+            distinct += !seen[c];
+            seen[c] = true;
+        }
+
+        if (distinct > best) {
+            pos = p;
+            best = distinct;
+        }
     }
 
-    if (opts->set_guard) {
-        fprintf(fout, " *   --guard %s\n", opts->guard.buf);
+    obpad(out, ' ', indent);
+    obputs(out, "switch (s[");
+    obint(out, pos, 0);
+    obputs(out, "]) {\n");
+
+    // Partition the members by their character at `pos`, keeping each group
+    // in table order.
+    usize *group = new (local, usize, n, A_F_EXTEND);
+    for (unsigned c = 0; c < 256; c++) {
+        usize g = 0;
+        for (usize i = 0; i < n; i++) {
+            if ((unsigned char)names[members[i]].buf[pos] == c) {
+                group[g++] = members[i];
+            }
+        }
+
+        if (g > 0) {
+            obpad(out, ' ', indent);
+            if (isalnum(c) || c == '_') {
+                obputs(out, "case '");
+                obpad(out, (char)c, 1);
+                obputs(out, "':\n");
+            } else {
+                obputs(out, "case (char)");
+                obint(out, c, 0);
+                obputs(out, ":\n");
+            }
+            write_switch(names, group, g, len, depth + 1, out);
+        }
+    }
+
+    obpad(out, ' ', indent);
+    obputs(out, "}\n");
+    obpad(out, ' ', indent);
+    obputs(out, "return -1;\n");
+}
+
+static isize *build_namelens(outlist *genned, usize count, const str *leader)
+{
+    isize *namelens = new (local, isize, count, A_F_ZERO | A_F_EXTEND);
+    for (usize i = 0; i < count; i++) {
+        namelens[i] = leader->len + genned->table[i].len;
     }
 
-    if (!(opts->mode & OPTS_M_MASK)) {
-        for (usize i = 0; i < opts->append_count; i++) {
-            fprintf(fout, " *   --append %s\n", opts->append[i].buf);
+    return namelens;
+}
+
+// Join each name in the sorted table to the leader.
+static str *build_names(outlist *genned, usize count, const str *leader)
+{
+    str *names = new (local, str, count, A_F_EXTEND);
+    for (usize i = 0; i < count; i++) {
+        usize len = leader->len + genned->table[i].len;
+        char *buf = new (local, char, len + 1, A_F_EXTEND);
+        memcpy(buf, leader->buf, leader->len);
+        memcpy(buf + leader->len, genned->table[i].buf, genned->table[i].len + 1);
+        names[i] = strnew(buf, len);
+    }
+
+    return names;
+}
+
+// Compute the offset of each name in the sorted table within a pool of all
+// names, each terminated by a NUL. The size of the pool follows the last
+// offset, so that the length of each name is the distance to the next offset,
+// less one.
+static isize *build_offsets(outlist *genned, usize count, const str *leader)
+{
+    isize *offsets = new (local, isize, count + 1, A_F_ZERO | A_F_EXTEND);
+    usize ofs = 0;
+    for (usize i = 0; i < count; i++) {
+        offsets[i] = ofs;
+        ofs += leader->len + genned->table[i].len + 1;
+    }
+    offsets[count] = ofs;
+
+    if (ofs > UINT32_MAX) {
+        fprintf(stderr, "metang: Names are too large to be pooled\n");
+        longjmp(local->env, 1);
+    }
+
+    return offsets;
+}
+
+// Find the position of `name` in the sorted table.
+static usize find_sorted(outlist *genned, usize count, const str *name)
+{
+    str *found = bsearch(name, genned->table, count, sizeof(str), qsort_strcmp);
+    return found - genned->table;
+}
+
+#define PHF_MAX_ATTEMPTS (1 << 24)
+
+// Construct a minimal perfect hash over the sorted table using the "hash,
+// displace, and compress" scheme: keys are first distributed into `count`
+// buckets using a seed of 0, then each bucket is assigned a displacement seed
+// which maps all of its keys onto unused slots. Buckets are resolved largest
+// first; buckets holding a single key are instead pointed directly at a free
+// slot, which is encoded as a negative displacement.
+//
+// On return, `disp` holds the displacement for each bucket, and the returned
+// array maps each slot to an index in the sorted table.
+static isize *build_phf(outlist *genned, usize count, const str *leader, isize *disp)
+{
+    isize *slots = new (local, isize, count, A_F_ZERO | A_F_EXTEND);
+    usize *buckets = new (local, usize, count, A_F_ZERO | A_F_EXTEND);
+    usize *sizes = new (local, usize, count, A_F_ZERO | A_F_EXTEND);
+    usize *starts = new (local, usize, count + 1, A_F_ZERO | A_F_EXTEND);
+    usize *fill = new (local, usize, count, A_F_ZERO | A_F_EXTEND);
+    usize *members = new (local, usize, count, A_F_ZERO | A_F_EXTEND);
+    usize *order = new (local, usize, count, A_F_ZERO | A_F_EXTEND);
+    usize *bysize = new (local, usize, count + 1, A_F_ZERO | A_F_EXTEND);
+    usize *trial = new (local, usize, count, A_F_ZERO | A_F_EXTEND);
+    byte *taken = new (local, byte, count, A_F_ZERO | A_F_EXTEND);
+
+    for (usize i = 0; i < count; i++) {
+        buckets[i] = phf_hash(0, leader, &genned->table[i]) % count;
+        sizes[buckets[i]]++;
+    }
+
+    // Group keys by bucket, then counting-sort the buckets by descending size.
+    for (usize b = 0; b < count; b++) {
+        starts[b + 1] = starts[b] + sizes[b];
+        bysize[sizes[b]]++;
+    }
+
+    for (usize i = 0; i < count; i++) {
+        members[starts[buckets[i]] + fill[buckets[i]]] = i;
+        fill[buckets[i]]++;
+    }
+
+    for (usize n = count + 1, ofs = 0; n > 0; n--) {
+        usize c = bysize[n - 1];
+        bysize[n - 1] = ofs;
+        ofs += c;
+    }
+
+    for (usize b = 0; b < count; b++) {
+        order[bysize[sizes[b]]] = b;
+        bysize[sizes[b]]++;
+    }
+
+    usize next_free = 0;
+    for (usize o = 0; o < count && sizes[order[o]] > 0; o++) {
+        usize b = order[o];
+        usize size = sizes[b];
+        usize *keys = members + starts[b];
+
+        if (size == 1) {
+            while (taken[next_free]) {
+                next_free++;
+            }
+
+            taken[next_free] = true;
+            slots[next_free] = keys[0];
+            disp[b] = -(isize)next_free - 1;
+            continue;
         }
 
-        for (usize i = 0; i < opts->prepend_count; i++) {
-            fprintf(fout, " *   --prepend %s\n", opts->prepend[i].buf);
+        u32 d = 0;
+        usize k = 0;
+        while (k < size) {
+            d++;
+            if (d == PHF_MAX_ATTEMPTS) {
+                fprintf(stderr, "metang: Could not construct a perfect hash for the input\n");
+                longjmp(local->env, 1);
+            }
+
+            for (k = 0; k < size; k++) {
+                usize slot = phf_hash(d, leader, &genned->table[keys[k]]) % count;
+                usize j = 0;
+                while (j < k && trial[j] != slot) {
+                    j++;
+                }
+
+                if (taken[slot] || j < k) {
+                    break;
+                }
+
+                trial[k] = slot;
+            }
         }
 
-        if (opts->set_start) {
-            fprintf(fout, " *   --start-from %ld\n", opts->start);
+        for (k = 0; k < size; k++) {
+            taken[trial[k]] = true;
+            slots[trial[k]] = keys[k];
         }
+        disp[b] = d;
     }
+
+    return slots;
 }
 
-static str make_prefix(const str *prefix)
+// A reverse index may be dense so long as no more than half of its members
+// would be left empty.
+#define REVERSE_MAX_SPARSITY 2
+
+// Construct a value-to-name index over the table in declaration order. If the
+// range of values is dense enough, then `order` will hold one member for each
+// value in the range, each storing the position of the first entry declared
+// with that value, or -1 if no such entry exists. Otherwise, `order` will hold
+// the position of each entry, sorted by value and then by declaration.
+//
+// This must be called before the table is sorted by name.
+static reverse *build_reverse(outlist *genned, usize count)
 {
-    if (prefix->len == 0) {
-        char *buf = new (local, char, 1 << 8, A_F_ZERO | A_F_EXTEND);
-        return strnew(buf, 0);
+    reverse *rev = new (local, reverse, 1, A_F_ZERO | A_F_EXTEND);
+    rev->min = genned->values[0];
+    rev->max = genned->values[0];
+    for (usize i = 1; i < count; i++) {
+        rev->min = genned->values[i] < rev->min ? genned->values[i] : rev->min;
+        rev->max = genned->values[i] > rev->max ? genned->values[i] : rev->max;
     }
 
-    char *buf = new (local, char, 1 << 8, A_F_ZERO | A_F_EXTEND);
-    str cased = strsnake(prefix, buf, NULL, S_SNAKE_F_UPPER);
-    cased.buf[cased.len] = '_';
-    cased.buf[cased.len + 1] = '\0';
-    cased.len++;
+    usize range = (usize)rev->max - (usize)rev->min;
+    rev->dense = range < count * REVERSE_MAX_SPARSITY;
+    if (rev->dense) {
+        rev->span = range + 1;
+        rev->order = new (local, isize, rev->span, A_F_EXTEND);
+        memset(rev->order, -1, rev->span * sizeof(isize));
+
+        for (usize i = count; i > 0; i--) {
+            rev->order[genned->values[i - 1] - rev->min] = i - 1;
+        }
+
+        return rev;
+    }
 
-    return cased;
+    valpos *sorted = new (local, valpos, count, A_F_EXTEND);
+    for (usize i = 0; i < count; i++) {
+        sorted[i] = (valpos){ .value = genned->values[i], .pos = i };
+    }
+    qsort(sorted, count, sizeof(valpos), qsort_valcmp);
+
+    rev->span = count;
+    rev->order = new (local, isize, count, A_F_EXTEND);
+    for (usize i = 0; i < count; i++) {
+        rev->order[i] = sorted[i].pos;
+    }
+
+    return rev;
 }
 
-static str make_basename(const str *fname)
+// This must exactly mirror the `hash__<tag>` function emitted by
+// `write_index_hash`: FNV-1a over the seeded basis, then a 32-bit finalizer.
+static u32 phf_hash(u32 seed, const str *leader, const str *name)
 {
-    char *buf = new (local, char, 1 << 8, A_F_ZERO | A_F_EXTEND);
-    str fbase = strrcut(fname, '/').tail;
-    return strsnake(&fbase, buf, &strnew("."), S_SNAKE_F_UPPER);
+    u32 h = seed ^ 2166136261u;
+    for (usize i = 0; i < leader->len; i++) {
+        h = (h ^ (byte)leader->buf[i]) * 16777619u;
+    }
+    for (usize i = 0; i < name->len; i++) {
+        h = (h ^ (byte)name->buf[i]) * 16777619u;
+    }
+
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// Choose the narrowest type which holds every value of the enumeration.
+static const char *valuetype(outlist *genned, usize count)
+{
+    isize min = genned->values[0];
+    isize max = genned->values[0];
+    for (usize i = 1; i < count; i++) {
+        min = genned->values[i] < min ? genned->values[i] : min;
+        max = genned->values[i] > max ? genned->values[i] : max;
+    }
+
+    return inttype(min, max);
 }
 
 static int qsort_strcmp(const void *a, const void *b)
@@ -351,3 +1359,4 @@ static int qsort_strcmp(const void *a, const void *b)
     const str *s2 = b;
     return strcmp(s1->buf, s2->buf);
 }
+
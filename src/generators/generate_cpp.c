@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "generator.h"
+#include "meta.h"
+#include "options.h"
+#include "outbuf.h"
+#include "strbuf.h"
+#include "template.h"
+
+// Slots which may be used by the templates below.
+enum slot {
+    S_WARNING,
+    S_MODE,
+    S_INFILE,
+    S_GUARD,
+    S_BASENAME,
+    S_TAG,
+    S_COUNT,
+    S_VALUE_TYPE,
+
+    NUM_SLOTS,
+};
+
+enum tmpl {
+    T_HEADER,
+    T_INIT_GUARDS,
+    T_ENUM,
+    T_ENTRY,
+    T_TO_STRING,
+    T_TO_STRING_FOOTER,
+    T_FROM_STRING,
+    T_FOOTER,
+
+    NUM_TEMPLATES,
+};
+
+static void write_enum(outlist *genned, usize count, usize max_ident_len, tmplarg *args, outbuf *out);
+static void write_table(outlist *genned, usize count, usize max_ident_len, const char *tag, const tmplarg *args, outbuf *out);
+static void write_to_string(outlist *genned, usize count, usize max_ident_len, const char *tag, const tmplarg *args, outbuf *out);
+
+static _Thread_local arena *local;
+
+// clang-format off
+static const char *const slots[] = {
+    [S_WARNING]    = "warning",
+    [S_MODE]       = "mode",
+    [S_INFILE]     = "infile",
+    [S_GUARD]      = "guard",
+    [S_BASENAME]   = "basename",
+    [S_TAG]        = "tag",
+    [S_COUNT]      = "count",
+    [S_VALUE_TYPE] = "value_type",
+};
+
+static const char *const srcs[] = {
+    [T_HEADER] = ""
+        "/*\n"
+        " * ${warning}\n"
+        " * Base command: ${mode}\n"
+        " * Source file: ${infile}\n"
+        " * Program options:\n",
+
+    [T_INIT_GUARDS] = ""
+        " */\n"
+        "\n"
+        "#ifndef ${guard}${basename}\n"
+        "#define ${guard}${basename}\n"
+        "\n"
+        "#include <array>\n"
+        "#include <cstddef>\n"
+        "#include <cstdint>\n"
+        "#include <string_view>\n"
+        "\n",
+
+    [T_ENUM] = "enum class ${tag} : std::${value_type} {\n",
+
+    [T_ENTRY] = ""
+        "\n"
+        "struct entry__${tag} {\n"
+        "    ${tag} value;\n"
+        "    std::string_view name;\n"
+        "};\n"
+        "\n"
+        "inline constexpr std::array<entry__${tag}, ${count}> lookup__${tag} = {{\n",
+
+    [T_TO_STRING] = ""
+        "\n"
+        "/* Return the name of the first entry declared with the given value, or an\n"
+        " * empty view. */\n"
+        "constexpr std::string_view to_string(${tag} value) noexcept\n"
+        "{\n"
+        "    switch (value) {\n",
+
+    [T_TO_STRING_FOOTER] = ""
+        "    }\n"
+        "\n"
+        "    return {};\n"
+        "}\n",
+
+    [T_FROM_STRING] = ""
+        "\n"
+        "/* Parse the given name into its value. Return true on success, or false if no\n"
+        " * entry has that name. */\n"
+        "constexpr bool from_string(std::string_view name, ${tag} &value) noexcept\n"
+        "{\n"
+        "    std::size_t i = 0;\n"
+        "    for (std::size_t n = lookup__${tag}.size(); n > 1; n -= n / 2) {\n"
+        "        i = lookup__${tag}[i + n / 2].name < name ? i + n / 2 : i;\n"
+        "    }\n"
+        "\n"
+        "    i += lookup__${tag}[i].name < name;\n"
+        "    if (i < lookup__${tag}.size() && lookup__${tag}[i].name == name) {\n"
+        "        value = lookup__${tag}[i].value;\n"
+        "        return true;\n"
+        "    }\n"
+        "\n"
+        "    return false;\n"
+        "}\n",
+
+    [T_FOOTER] = ""
+        "\n"
+        "#endif /* ${guard}${basename} */\n",
+};
+// clang-format on
+
+static template compiled[NUM_TEMPLATES];
+
+tmplset cpp_templates = {
+    .srcs = srcs,
+    .count = NUM_TEMPLATES,
+    .slots = slots,
+    .nslots = NUM_SLOTS,
+    .compiled = compiled,
+};
+
+static inline void render(outbuf *out, enum tmpl t, const tmplarg *args)
+{
+    tmplrender(out, &compiled[t], args);
+}
+
+bool generate_cpp(enumerator *input, options *opts, arena *a, const outdest *out)
+{
+    if (input == NULL || input->count == 0 || out == NULL) {
+        return false;
+    }
+
+    scratch s;
+    scratch_begin(&s, a);
+    local = a;
+    if (setjmp(local->env)) {
+        scratch_end(&s);
+        return false;
+    }
+
+    str leader = make_prefix(local, &opts->leader);
+    str guardp = make_prefix(local, &opts->guard);
+    str foutbn = make_basename(local, &opts->outfile);
+    usize max_ident_len = leader.len + input->max_ident_len;
+
+    // Values follow the same rules as for C.
+    outlist *genned = stringify(local, input, &leader, opts->mode);
+
+    tmplarg args[NUM_SLOTS] = {
+        [S_WARNING] = TSTR(header_warning.buf),
+        [S_MODE] = TSTR(opts->mode & OPTS_M_ENUM ? "enum" : "mask"),
+        [S_INFILE] = TSTR(opts->infile.buf),
+        [S_GUARD] = TSTR(guardp.buf),
+        [S_BASENAME] = TSTR(foutbn.buf),
+        [S_TAG] = TSTR(opts->tag.buf),
+        [S_COUNT] = TINT(input->count),
+    };
+
+    outbuf ob = obnew(local, 1 << 16);
+    render(&ob, T_HEADER, args);
+    obputs(&ob, " *   --lang cpp\n");
+    write_options(opts, " *   ", &ob);
+    write_input_options(opts, " *   ", &ob);
+    render(&ob, T_INIT_GUARDS, args);
+
+    write_enum(genned, input->count, max_ident_len, args, &ob);
+    write_to_string(genned, input->count, max_ident_len, opts->tag.buf, args, &ob);
+
+    // The table is searched by name, so it must be sorted by name.
+    str *declared = genned->table;
+    genned->table = new (local, str, input->count, A_F_EXTEND);
+    memcpy(genned->table, declared, input->count * sizeof(str));
+    strsort(genned->table, input->count, opts->threads);
+
+    write_table(genned, input->count, max_ident_len, opts->tag.buf, args, &ob);
+
+    render(&ob, T_FROM_STRING, args);
+    render(&ob, T_FOOTER, args);
+
+    bool ok = obcommit(&ob, out);
+    scratch_end(&s);
+    return ok;
+}
+
+static void write_enum(outlist *genned, usize count, usize max_ident_len, tmplarg *args, outbuf *out)
+{
+    isize min = genned->values[0];
+    isize max = genned->values[0];
+    usize width = 1;
+    for (usize i = 0; i < count; i++) {
+        min = genned->values[i] < min ? genned->values[i] : min;
+        max = genned->values[i] > max ? genned->values[i] : max;
+
+        usize w = intlen(genned->values[i]);
+        width = w > width ? w : width;
+    }
+
+    args[S_VALUE_TYPE] = TSTR(inttype(min, max));
+    render(out, T_ENUM, args);
+    for (usize i = 0; i < count; i++) {
+        const str *name = &genned->table[i];
+        obputs(out, "    ");
+        obstr(out, name);
+        obpad(out, ' ', max_ident_len - name->len);
+        obputs(out, " = ");
+        obint(out, genned->values[i], width);
+        obputs(out, ",\n");
+    }
+    obputs(out, "};\n");
+}
+
+static void write_table(outlist *genned, usize count, usize max_ident_len, const char *tag, const tmplarg *args, outbuf *out)
+{
+    render(out, T_ENTRY, args);
+    for (usize i = 0; i < count; i++) {
+        const str *name = &genned->table[i];
+        usize padding = max_ident_len - name->len + 1;
+        obputs(out, "    { ");
+        obputs(out, tag);
+        obputs(out, "::");
+        obstr(out, name);
+        obputs(out, ",");
+        obpad(out, ' ', padding);
+        obputs(out, "\"");
+        obstr(out, name);
+        obputs(out, "\",");
+        obpad(out, ' ', padding);
+        obputs(out, "},\n");
+    }
+    obputs(out, "}};\n");
+}
+
+// A switch can hold only one case per value, so only the first member declared
+// with each value is named.
+static void write_to_string(outlist *genned, usize count, usize max_ident_len, const char *tag, const tmplarg *args, outbuf *out)
+{
+    valpos *byvalue = new (local, valpos, count, A_F_EXTEND);
+    for (usize i = 0; i < count; i++) {
+        byvalue[i] = (valpos){ .value = genned->values[i], .pos = i };
+    }
+    qsort(byvalue, count, sizeof(valpos), qsort_valcmp);
+
+    render(out, T_TO_STRING, args);
+    for (usize i = 0; i < count; i++) {
+        if (i > 0 && byvalue[i].value == byvalue[i - 1].value) {
+            continue;
+        }
+
+        const str *name = &genned->table[byvalue[i].pos];
+        obputs(out, "    case ");
+        obputs(out, tag);
+        obputs(out, "::");
+        obstr(out, name);
+        obputs(out, ":");
+        obpad(out, ' ', max_ident_len - name->len + 1);
+        obputs(out, "return \"");
+        obstr(out, name);
+        obputs(out, "\";\n");
+    }
+    render(out, T_TO_STRING_FOOTER, args);
+}
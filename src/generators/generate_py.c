@@ -6,220 +6,247 @@
 #include "generator.h"
 #include "meta.h"
 #include "options.h"
+#include "outbuf.h"
 #include "strbuf.h"
+#include "template.h"
 
-static outlist *stringify(enumerator *input, const str *leader, enum options_mode mode);
-static void stringify_enumeration(enumerator *input, const str *leader, outlist *outputs, usize max_ident_len);
-static void stringify_bitmask(enumerator *input, const str *leader, outlist *outputs, usize max_ident_len);
+// Slots which may be used by the templates below.
+enum slot {
+    S_WARNING,
+    S_MODE,
+    S_INFILE,
+    S_TAG,
+    S_BASE,
 
-static void write_options(options *opts, FILE *fout);
-static str make_prefix(const str *prefix);
+    NUM_SLOTS,
+};
 
-static arena *local;
+enum tmpl {
+    T_HEADER,
+    T_IMPORTS,
+    T_CONST_INIT,
+    T_LOOKUP,
+    T_NAMES_TUPLE,
+    T_NAMES_DICT,
+    T_LAZY_CLASS,
+
+    NUM_TEMPLATES,
+};
+
+static void write_py_options(options *opts, outbuf *out);
+static void write_lookup(outlist *genned, usize count, const tmplarg *args, outbuf *out);
+static void write_names(outlist *genned, usize count, const tmplarg *args, outbuf *out);
+
+static _Thread_local arena *local;
 
 // clang-format off
-static const char *enum_fmt = "    %-*.*s = %*ld\n";
-static const char *mask_fmt = "    %-*.*s =  (1 << %*ld)\n";
-static const char *mask_fmt_0 = "    %-*.*s =        %*ld\n";
-static const char *mask_fmt_l = "    %-*.*s = ((1 << %*ld) - 1)\n";
-
-static const char *header_fmt = ""
-    "\"\"\"\n"
-    "    %s\n"
-    "    Base command: %s\n"
-    "    Source file: %s\n"
-    "    Program options:\n"
-    "";
-
-static const char *imports_fmt = ""
-    "\"\"\"\n"
-    "\n"
-    "import enum\n"
-    "\n"
-    "class %s(enum.%s):\n"
-    "";
+// An enumeration member, then the first, inner, and last members of a mask.
+static const entryfmt entries[] = {
+    { " = ",        "\n" },
+    { " =        ", "\n" },
+    { " =  (1 << ", ")\n" },
+    { " = ((1 << ", ") - 1)\n" },
+};
+
+static const char *const slots[] = {
+    [S_WARNING] = "warning",
+    [S_MODE]    = "mode",
+    [S_INFILE]  = "infile",
+    [S_TAG]     = "tag",
+    [S_BASE]    = "base",
+};
+
+static const char *const srcs[] = {
+    [T_HEADER] = ""
+        "\"\"\"\n"
+        "    ${warning}\n"
+        "    Base command: ${mode}\n"
+        "    Source file: ${infile}\n"
+        "    Program options:\n",
+
+    [T_IMPORTS] = ""
+        "\"\"\"\n"
+        "\n"
+        "import enum\n"
+        "\n"
+        "class ${tag}(enum.${base}):\n",
+
+    [T_CONST_INIT] = ""
+        "\"\"\"\n"
+        "\n",
+
+    [T_LOOKUP]      = "\nlookup__${tag} = {\n",
+    [T_NAMES_TUPLE] = "\nnames__${tag} = (\n",
+    [T_NAMES_DICT]  = "\nnames__${tag} = {\n",
+
+    [T_LAZY_CLASS] = ""
+        "\n"
+        "def __getattr__(name):\n"
+        "    # Build the class on first access, so that importing the module does not.\n"
+        "    if name != \"${tag}\":\n"
+        "        raise AttributeError(f\"module {__name__!r} has no attribute {name!r}\")\n"
+        "\n"
+        "    import enum\n"
+        "\n"
+        "    cls = enum.${base}(\"${tag}\", lookup__${tag}, module=__name__)\n"
+        "    globals()[name] = cls\n"
+        "    return cls\n",
+};
 // clang-format on
 
-bool generate_py(enumerator *input, options *opts, FILE *fout)
+static template compiled[NUM_TEMPLATES];
+
+tmplset py_templates = {
+    .srcs = srcs,
+    .count = NUM_TEMPLATES,
+    .slots = slots,
+    .nslots = NUM_SLOTS,
+    .compiled = compiled,
+};
+
+static inline void render(outbuf *out, enum tmpl t, const tmplarg *args)
+{
+    tmplrender(out, &compiled[t], args);
+}
+
+bool generate_py(enumerator *input, options *opts, arena *a, const outdest *out)
 {
-    if (input == NULL || fout == NULL) {
+    if (input == NULL || input->count == 0 || out == NULL) {
         return false;
     }
 
-    arena a = arena_new(1 << 16);
-    local = &a;
+    scratch s;
+    scratch_begin(&s, a);
+    local = a;
     if (setjmp(local->env)) {
-        free(local->mem);
+        scratch_end(&s);
         return false;
     }
 
-    str leader = make_prefix(&opts->leader);
-    outlist *genned = stringify(input, &leader, opts->mode);
+    str leader = make_prefix(local, &opts->leader);
+    outlist *genned = stringify(local, input, &leader, opts->mode);
 
-    fprintf(fout, header_fmt,
-            header_warning.buf,
-            opts->mode & OPTS_M_ENUM ? "enum" : "mask",
-            opts->infile.buf);
+    const tmplarg args[NUM_SLOTS] = {
+        [S_WARNING] = TSTR(header_warning.buf),
+        [S_MODE] = TSTR(opts->mode & OPTS_M_ENUM ? "enum" : "mask"),
+        [S_INFILE] = TSTR(opts->infile.buf),
+        [S_TAG] = TSTR(opts->tag.buf),
+        [S_BASE] = TSTR(opts->mode & OPTS_M_ENUM ? "IntEnum" : "IntFlag"),
+    };
 
-    write_options(opts, fout);
+    outbuf ob = obnew(local, 1 << 16);
+    render(&ob, T_HEADER, args);
+    write_py_options(opts, &ob);
 
-    fprintf(fout, imports_fmt,
-            opts->tag.buf,
-            opts->mode & OPTS_M_ENUM ? "IntEnum" : "IntFlag");
+    if (opts->py_style == OPTS_P_CLASS) {
+        render(&ob, T_IMPORTS, args);
+        write_members(input, &leader, opts->mode, entries, "    ", &ob);
+    } else {
+        // Building an enum class is costly for large inputs, so these styles
+        // emit plain module-level constants and literal tables instead.
+        render(&ob, T_CONST_INIT, args);
+        write_members(input, &leader, opts->mode, entries, "", &ob);
+        write_lookup(genned, input->count, args, &ob);
+        write_names(genned, input->count, args, &ob);
+    }
 
-    strlist *e_curr = genned->enums;
-    for (; e_curr; e_curr = e_curr->next) {
-        fwrite(e_curr->elem.buf, 1, e_curr->elem.len, fout);
+    if (opts->py_style == OPTS_P_LAZY) {
+        render(&ob, T_LAZY_CLASS, args);
     }
 
-    free(local->mem);
-    return true;
+    bool ok = obcommit(&ob, out);
+    scratch_end(&s);
+    return ok;
 }
 
-static outlist *stringify(enumerator *input, const str *leader, enum options_mode mode)
+static void write_py_options(options *opts, outbuf *out)
 {
-    outlist *outputs = new (local, outlist, 1, A_F_ZERO | A_F_EXTEND);
-    outputs->enums = NULL;
-    outputs->procs = NULL;
-    outputs->table = new (local, str, input->count, A_F_ZERO | A_F_EXTEND);
+    obputs(out, "      --lang py\n");
+    write_options(opts, "      ", out);
 
-    if (mode == OPTS_M_ENUM) {
-        stringify_enumeration(input, leader, outputs, input->max_ident_len + leader->len);
-    } else {
-        stringify_bitmask(input, leader, outputs, input->max_ident_len + leader->len);
+    if (opts->py_style != OPTS_P_CLASS) {
+        obputs(out, "      --py-style ");
+        obputs(out, opts->py_style == OPTS_P_CONST ? "const" : "lazy");
+        obputs(out, "\n");
     }
 
-    return outputs;
+    write_input_options(opts, "      ", out);
 }
 
-static inline char *stringify_entry(
-    const str *leader,
-    usize symbol_len,
-    usize assign_len,
-    usize column_len,
-    usize entry_len,
-    isize assignment,
-    const char *fmt)
+// Entries are kept in declaration order, which is also the order in which the
+// lazily-built class will declare its members.
+static void write_lookup(outlist *genned, usize count, const tmplarg *args, outbuf *out)
 {
-    char *entry = new (local, char, entry_len + 1, A_F_ZERO | A_F_EXTEND);
-    snprintf(entry,
-             entry_len + 1,
-             fmt,
-             column_len,
-             (int)symbol_len, leader->buf,
-             (int)assign_len, assignment);
-    return entry;
-}
+    usize max_len = 0;
+    usize width = 1;
+    for (usize i = 0; i < count; i++) {
+        max_len = genned->table[i].len > max_len ? genned->table[i].len : max_len;
 
-static void stringify_enumeration(enumerator *input, const str *leader, outlist *outputs, usize max_ident_len)
-{
-    usize enum_entry_len_base = max_ident_len + 8;
-    usize assign_len = input->max_assign_len;
-    char *bufp = leader->buf + leader->len;
-
-    strlist **e_tail = &outputs->enums;
-    enumerator *curr = input;
-
-    for (usize i = 0; curr; curr = curr->next, i++) {
-        str cased_elem = strsnake(&curr->ident, bufp, NULL, S_SNAKE_F_UPPER);
-        usize symbol_len = leader->len + cased_elem.len;
-
-        char *claimed_elem = claim(local, cased_elem.buf, cased_elem.len + 1, A_F_ZERO | A_F_EXTEND);
-        outputs->table[i] = strnew(claimed_elem, strlen(claimed_elem));
-
-        // Format an enum entry: '    ' -> symbol -> ' = ' -> assignment + '\n'
-        char *enum_entry = stringify_entry(leader,
-                                           symbol_len,
-                                           assign_len,
-                                           max_ident_len,
-                                           enum_entry_len_base + assign_len,
-                                           curr->assignment,
-                                           enum_fmt);
-        strlist_append(e_tail, local, strnew(enum_entry, strlen(enum_entry)), A_F_EXTEND);
+        usize w = intlen(genned->values[i]);
+        width = w > width ? w : width;
     }
-}
-
-static void stringify_bitmask(enumerator *input, const str *leader, outlist *outputs, usize max_ident_len)
-{
-    usize enum_entry_len_base = max_ident_len + 16;
-    usize assign_len = input->max_assign_len;
-    char *bufp = leader->buf + leader->len;
-
-    strlist **e_tail = &outputs->enums;
-    enumerator *curr = input;
-
-    for (usize i = 0; curr; curr = curr->next, i++) {
-        str cased_elem = strsnake(&curr->ident, bufp, NULL, S_SNAKE_F_UPPER);
-        usize symbol_len = leader->len + cased_elem.len;
-
-        char *claimed_elem = claim(local, cased_elem.buf, cased_elem.len + 1, A_F_ZERO | A_F_EXTEND);
-        outputs->table[i] = strnew(claimed_elem, strlen(claimed_elem));
-
-        const char *e_fmt = mask_fmt;
-        usize assignment = curr->assignment;
-        if (i == 0) { // first element
-            e_fmt = mask_fmt_0;
-            assignment = 1;              // gets set to 0 by the subtraction below
-        } else if (curr->next == NULL) { // last element
-            e_fmt = mask_fmt_l;
-            enum_entry_len_base += 5;
-        }
 
-        // Format an enum entry: '    ' -> symbol -> ' = ' -> assignment + '\n'
-        char *enum_entry = stringify_entry(leader,
-                                           symbol_len,
-                                           assign_len,
-                                           max_ident_len,
-                                           enum_entry_len_base + assign_len,
-                                           assignment - 1,
-                                           e_fmt);
-        strlist_append(e_tail, local, strnew(enum_entry, strlen(enum_entry)), A_F_EXTEND);
+    render(out, T_LOOKUP, args);
+    for (usize i = 0; i < count; i++) {
+        const str *name = &genned->table[i];
+        obputs(out, "    \"");
+        obstr(out, name);
+        obputs(out, "\":");
+        obpad(out, ' ', max_len - name->len + 1);
+        obint(out, genned->values[i], width);
+        obputs(out, ",\n");
     }
+    obputs(out, "}\n");
 }
 
-static void write_options(options *opts, FILE *fout)
+// Values which fall in a small, non-negative range are indexed directly by a
+// tuple, with None marking holes; anything else falls back to a dict. Either
+// way, each value maps to the first member declared with it.
+static void write_names(outlist *genned, usize count, const tmplarg *args, outbuf *out)
 {
-    fprintf(fout, "%s\n", "      --lang py");
-
-    if (opts->set_leader) {
-        fprintf(fout, "      --leader %s\n", opts->leader.buf);
-    }
-
-    if (opts->set_tag) {
-        fprintf(fout, "      --tag-name %s\n", opts->tag.buf);
-    }
-
-    if (opts->set_guard) {
-        fprintf(fout, "      --guard %s\n", opts->guard.buf);
+    valpos *byvalue = new (local, valpos, count, A_F_EXTEND);
+    for (usize i = 0; i < count; i++) {
+        byvalue[i] = (valpos){ .value = genned->values[i], .pos = i };
     }
-
-    if (!(opts->mode & OPTS_M_MASK)) {
-        for (usize i = 0; i < opts->append_count; i++) {
-            fprintf(fout, "      --append %s\n", opts->append[i].buf);
+    qsort(byvalue, count, sizeof(valpos), qsort_valcmp);
+
+    isize min = byvalue[0].value;
+    isize max = byvalue[count - 1].value;
+    if (min >= 0 && (usize)max < count * 2) {
+        render(out, T_NAMES_TUPLE, args);
+        for (usize i = 0, v = 0; i < count; i++) {
+            if (i > 0 && byvalue[i].value == byvalue[i - 1].value) {
+                continue;
+            }
+
+            for (; v < (usize)byvalue[i].value; v++) {
+                obputs(out, "    None,\n");
+            }
+
+            obputs(out, "    \"");
+            obstr(out, &genned->table[byvalue[i].pos]);
+            obputs(out, "\",\n");
+            v++;
         }
+        obputs(out, ")\n");
+        return;
+    }
 
-        for (usize i = 0; i < opts->prepend_count; i++) {
-            fprintf(fout, " *    --prepend %s\n", opts->prepend[i].buf);
-        }
+    usize width = intlen(min);
+    usize w = intlen(max);
+    width = w > width ? w : width;
 
-        if (opts->set_start) {
-            fprintf(fout, " *    --start-from %ld\n", opts->start);
+    render(out, T_NAMES_DICT, args);
+    for (usize i = 0; i < count; i++) {
+        if (i > 0 && byvalue[i].value == byvalue[i - 1].value) {
+            continue;
         }
-    }
-}
 
-static str make_prefix(const str *prefix)
-{
-    if (prefix->len == 0) {
-        char *buf = new (local, char, 1 << 8, A_F_ZERO | A_F_EXTEND);
-        return strnew(buf, 0);
+        obputs(out, "    ");
+        obint(out, byvalue[i].value, width);
+        obputs(out, ": \"");
+        obstr(out, &genned->table[byvalue[i].pos]);
+        obputs(out, "\",\n");
     }
-
-    char *buf = new (local, char, 1 << 8, A_F_ZERO | A_F_EXTEND);
-    str cased = strsnake(prefix, buf, NULL, S_SNAKE_F_UPPER);
-    cased.buf[cased.len] = '_';
-    cased.buf[cased.len + 1] = '\0';
-    cased.len++;
-
-    return cased;
+    obputs(out, "}\n");
 }
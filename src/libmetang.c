@@ -0,0 +1,117 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "libmetang.h"
+
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "generator.h"
+#include "outbuf.h"
+#include "parse.h"
+
+// Templates are compiled once per process, into an arena which lives as long
+// as the process does.
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static arena templates;
+static bool ready;
+
+// Each thread renders into a scratch arena of its own, which stays warm
+// between calls and is released when the thread exits. Outputs are copied
+// from there into the caller's arena.
+static pthread_key_t scratchkey;
+
+static void freescratch(void *p)
+{
+    arena_free(p);
+    free(p);
+}
+
+static void init(void)
+{
+    if (pthread_key_create(&scratchkey, freescratch) != 0) {
+        return;
+    }
+
+    templates = arena_new(1 << 16);
+    if (setjmp(templates.env)) {
+        return;
+    }
+
+    for (const generator *g = generators; g->genfunc; g++) {
+        if (!tmplcompile(&templates, g->templates)) {
+            return;
+        }
+    }
+
+    ready = true;
+}
+
+static arena *scratcharena(void)
+{
+    arena *a = pthread_getspecific(scratchkey);
+    if (a == NULL && (a = malloc(sizeof(*a))) != NULL) {
+        *a = arena_new(1 << 16);
+        pthread_setspecific(scratchkey, a);
+    }
+
+    return a;
+}
+
+bool mtopts(options *opts, enum options_mode mode, int argc, char **argv)
+{
+    opts->mode = mode;
+    if (!parseopts(&argc, &argv, opts)) {
+        return false;
+    }
+
+    opts->infile = opts->infile.len == 0 ? strnew("stdin") : opts->infile;
+    return true;
+}
+
+enumerator *mtparse(arena *a, const str *text, const options *opts)
+{
+    // The caller may be using `a->env` for failures of its own.
+    jmp_buf env;
+    memcpy(env, a->env, sizeof(env));
+
+    enumerator *e = NULL;
+    if (setjmp(a->env) == 0) {
+        e = enumerate(a, *text, opts);
+    }
+
+    memcpy(a->env, env, sizeof(env));
+    return e;
+}
+
+bool mtgenerate(arena *a, enumerator *input, options *opts, usize target, str *out, str *src)
+{
+    pthread_once(&once, init);
+    arena *scratch = scratcharena();
+    if (!ready || scratch == NULL || target >= opts->target_count || (opts->srcfile.len > 0 && src == NULL)) {
+        return false;
+    }
+
+    opts->genf = opts->targets[target];
+    opts->lang = generators[opts->genf].lang;
+    opts->outfile = opts->outfile_count > 0 ? opts->outfiles[target] : strnew("stdout");
+
+    outdest srcout = { .mem = a, .text = src };
+    outdest dest = { .mem = a, .text = out, .source = &srcout };
+    return generators[opts->genf].genfunc(input, opts, scratch, &dest);
+}
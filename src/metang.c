@@ -14,21 +14,37 @@
  * limitations under the License.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <errno.h>
+#include <pthread.h>
 #include <setjmp.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "alloc.h"
+#include "cache.h"
+#include "digest.h"
 #include "generator.h"
 #include "options.h"
+#include "parse.h"
+#include "outbuf.h"
+#include "serve.h"
 #include "strbuf.h"
 
+static int run(int argc, char **argv, options *opts, unsigned threads);
+static int batch(int argc, char **argv);
+static int serve(int argc, char **argv);
 static int pargv(int *argc, char ***argv, options *opts);
+static bool waitsonstdin(int argc, char **argv);
 static str fload(FILE *f);
-static enumerator *enumerate(FILE *f, options *opts);
+static void funload(void);
 
 extern const str version;
 extern const str tag_line;
@@ -38,15 +54,78 @@ extern const str global_options_section;
 extern const str enum_options_section;
 extern const str mask_notes_section;
 
-arena *global;
+// Each batch worker has an arena of its own.
+_Thread_local arena *global;
+
+// The loaded input lives outside of the global arena, so identifiers sliced
+// from it stay valid while the arena grows.
+static _Thread_local str source;
+static _Thread_local bool source_mapped;
+static _Thread_local bool source_kept;
+
+// A server keeps mapped inputs between requests, keyed by file identity, size,
+// and modification and status change times, so that an unchanged input is not
+// mapped and faulted in again for every job which reads it.
+#define MAX_KEPT_INPUTS 64
+
+typedef struct keptinput {
+    struct stat st;
+    str text;
+} keptinput;
+
+static _Thread_local keptinput *kept;
+static _Thread_local usize kept_next;
 
 int main(int argc, char **argv)
 {
+    // With a server to forward to, this process need not set anything up; if
+    // none is listening, then the command runs here as usual.
+    int exit = EXIT_FAILURE;
+    const char *sockpath = getenv("METANG_SOCKET");
+    if (sockpath && *sockpath
+        && !(argc > 1 && strcmp(argv[1], "serve") == 0)
+        && !waitsonstdin(argc, argv)
+        && srvforward(sockpath, argc, argv, &exit)) {
+        return exit;
+    }
+
     arena a = arena_new(1 << 16);
     global = &a;
 
-    FILE *fin = NULL, *fout = NULL;
     options *opts = malloc(sizeof(*opts));
+    if (setjmp(global->env)) {
+        goto cleanup;
+    }
+
+    for (const generator *g = generators; g->genfunc; g++) {
+        if (!tmplcompile(global, g->templates)) {
+            goto cleanup;
+        }
+    }
+
+    if (argc > 1 && strcmp(argv[1], "serve") == 0) {
+        exit = serve(argc - 2, argv + 2);
+    } else if (argc > 1 && strcmp(argv[1], "batch") == 0) {
+        exit = batch(argc - 2, argv + 2);
+    } else {
+        exit = run(argc, argv, opts, 0);
+    }
+
+cleanup:
+    arena_free(global);
+    free(opts);
+    return exit;
+}
+
+// Run a single job, as given by `argv`, using up to `threads` threads, or one
+// per processor if `threads` is 0. Everything the job claims from the global
+// arena is released before returning.
+static int run(int argc, char **argv, options *opts, unsigned threads)
+{
+    // Read again after a longjmp back into this frame.
+    FILE *volatile fin = NULL;
+    scratch s;
+    scratch_begin(&s, global);
 
     int exit = pargv(&argc, &argv, opts);
     if (exit) {
@@ -54,6 +133,8 @@ int main(int argc, char **argv)
         goto cleanup;
     }
 
+    opts->threads = threads;
+
 #ifndef NDEBUG
     printf("--- METANG OPTIONS ---\n");
     printf("mode:         “%s”\n", (opts->mode & OPTS_M_ENUM) ? "enum" : "mask");
@@ -95,44 +176,484 @@ int main(int argc, char **argv)
         goto cleanup;
     }
 
-    fout = opts->outfile.len == 0 ? stdout : fopen(opts->outfile.buf, "wb");
-    if (fout == NULL) {
-        fprintf(stderr,
-                "metang: could not open output file “%s”: %s",
-                opts->outfile.buf, strerror(errno));
-        goto cleanup;
-    }
-
     if (setjmp(global->env)) {
+        exit = EXIT_FAILURE;
         goto cleanup;
     }
 
     opts->infile = opts->infile.len == 0 ? strnew("stdin") : opts->infile;
-    opts->outfile = opts->outfile.len == 0 ? strnew("stdout") : opts->outfile;
-    enumerator *input = enumerate(fin, opts);
+    str text = fload(fin);
+
+    // With a cache, targets whose outputs are already stored skip parsing
+    // altogether, so the input is only digested up front.
+    u8 sum[DIGEST_LEN];
+    if (opts->cachedir.len > 0) {
+        digest d;
+        dginit(&d);
+        dgwrite(&d, text.buf, text.len);
+        dgfinal(&d, sum);
+    }
+
+    // The input is parsed and cased at most once, then handed to each target
+    // in turn; each generator releases its scratch space before the next one
+    // runs. Output files are only written if their contents change.
+    enumerator *input = NULL;
+    for (usize t = 0; t < opts->target_count; t++) {
+        opts->genf = opts->targets[t];
+        opts->lang = generators[opts->genf].lang;
+        opts->outfile = opts->outfile_count > 0 ? opts->outfiles[t] : strnew("stdout");
+
+        outdest out = { .path = opts->outfile_count > 0 ? opts->outfile.buf : NULL, .stream = stdout };
+        outdest srcout = { .path = opts->srcfile.buf };
+        if (opts->cachedir.len > 0) {
+            // Only the C generator, which is always first, splits off a source.
+            bool ok;
+            out.cache = cachepath(global, &opts->cachedir, sum, opts);
+            if (opts->genf == 0 && opts->srcfile.len > 0) {
+                srcout.cache = cachesrc(global, out.cache);
+                out.source = &srcout;
+            }
+
+            if (cachefetch(&out, &ok)) {
+                if (!ok) {
+                    exit = EXIT_FAILURE;
+                    break;
+                }
+
+                continue;
+            }
+        }
+
+        if (input == NULL) {
+            input = enumerate(global, text, opts);
 
 #ifndef NDEBUG
-    printf("--- METANG INPUT ---\n");
+            printf("--- METANG INPUT ---\n");
 
-    enumerator *line = input;
-    while (line) {
-        printf("%.*s = %ld\n", (int)line->ident.len, line->ident.buf, line->assignment);
-        line = line->next;
-    }
+            for (usize i = 0; i < input->count; i++) {
+                printf("%.*s = %ld\n", (int)input->names[i].len, input->names[i].buf, input->assignments[i]);
+            }
 
-    printf("--- METANG OUTPUT ---\n");
+            printf("--- METANG OUTPUT ---\n");
 #endif // NDEBUG
+        }
 
-    generators[opts->genf].genfunc(input, opts, fout);
+        if (!generators[opts->genf].genfunc(input, opts, global, &out)) {
+            exit = EXIT_FAILURE;
+            break;
+        }
+    }
 
 cleanup:
-    fin ? fclose(fin) : 0;
-    fout ? fclose(fout) : 0;
-    free(global->mem);
+    funload();
+    fin && fin != stdin ? fclose(fin) : 0;
+    scratch_end(&s);
+    return exit;
+}
+
+typedef struct batchjob {
+    char *line;
+    usize lineno;
+} batchjob;
+
+// Each worker starts with a contiguous run of jobs, which it takes from the
+// front. A worker whose run is empty steals from the back of another's, so
+// that a few huge schemas cannot leave the other workers idle.
+typedef struct jobqueue {
+    pthread_mutex_t lock;
+    usize head;
+    usize tail;
+} jobqueue;
+
+typedef struct jobpool {
+    const char *path;
+    batchjob *jobs;
+    jobqueue *queues;
+    usize nworkers;
+} jobpool;
+
+typedef struct worker {
+    jobpool *pool;
+    usize id;
+    bool failed;
+    bool started;
+    pthread_t thread;
+} worker;
+
+static batchjob *take(jobpool *pool, usize self)
+{
+    batchjob *job = NULL;
+    for (usize i = 0; job == NULL && i < pool->nworkers; i++) {
+        jobqueue *q = &pool->queues[(self + i) % pool->nworkers];
+        pthread_mutex_lock(&q->lock);
+        if (q->head < q->tail) {
+            job = i == 0 ? &pool->jobs[q->head++] : &pool->jobs[--q->tail];
+        }
+        pthread_mutex_unlock(&q->lock);
+    }
+
+    return job;
+}
+
+// Run a batch job with a landing point of its own, so that a failure before
+// `run` sets one cannot jump into the frame of an earlier job, or into a new
+// worker's arena whose `env` was never set. Whatever the job claimed from the
+// arena is released either way.
+static int runjob(int argc, char **argv, options *opts, unsigned threads)
+{
+    scratch s;
+    scratch_begin(&s, global);
+    if (setjmp(global->env)) {
+        scratch_end(&s);
+        return EXIT_FAILURE;
+    }
+
+    int exit = run(argc, argv, opts, threads);
+    scratch_end(&s);
+    return exit;
+}
+
+// Split the manifest line `line` in place into words, as a shell would, and
+// store them in `args`. Words are separated by whitespace, which a word may
+// hold within quotes: single quotes keep everything up to the next one, and
+// elsewhere, a backslash keeps the character after it. Return the number of
+// words, or -1 if a quote is left open.
+static int splitjob(char *line, char **args)
+{
+    static const char space[] = " \t\r\n";
+
+    int argc = 0;
+    char *p = line + strspn(line, space);
+    while (*p != '\0') {
+        // A word never grows as its quotes are removed, so it is written over
+        // itself.
+        char *w = p;
+        char quote = '\0';
+        args[argc++] = w;
+        for (; *p != '\0' && (quote || strchr(space, *p) == NULL); p++) {
+            if (*p == quote) {
+                quote = '\0';
+            } else if (quote == '\0' && (*p == '\'' || *p == '"')) {
+                quote = *p;
+            } else if (*p == '\\' && quote != '\'' && p[1] != '\0') {
+                *w++ = *++p;
+            } else {
+                *w++ = *p;
+            }
+        }
+
+        if (quote) {
+            return -1;
+        }
+
+        char *next = *p != '\0' ? p + 1 : p;
+        *w = '\0';
+        p = next + strspn(next, space);
+    }
+
+    return argc;
+}
+
+// Split each job into a command and its arguments, then run it.
+// Jobs on parallel workers run on one thread each, rather than multiplying the
+// workers by the threads which each job might start.
+// Every worker but the first runs on a thread of its own, with its own arena.
+static void *work(void *arg)
+{
+    worker *self = arg;
+    jobpool *pool = self->pool;
+
+    arena a;
+    if (self->id > 0) {
+        a = arena_new(1 << 16);
+        global = &a;
+    }
+
+    options *opts = malloc(sizeof(*opts));
+    char **args = NULL;
+    usize argcap = 0;
+    batchjob *job;
+    while (opts && (job = take(pool, self->id)) != NULL) {
+        // Every argument needs at least two bytes, so this bounds their count.
+        usize need = strlen(job->line) / 2 + 3;
+        if (need > argcap) {
+            char **targs = realloc(args, need * sizeof(char *));
+            if (targs == NULL) {
+                fprintf(stderr, "metang: %s:%zu: out of memory\n", pool->path, job->lineno);
+                self->failed = true;
+                break;
+            }
+
+            args = targs;
+            argcap = need;
+        }
+
+        args[0] = "metang";
+        int argc = splitjob(job->line, args + 1);
+        if (argc < 0) {
+            fprintf(stderr, "metang: %s:%zu: unterminated quote\n", pool->path, job->lineno);
+            self->failed = true;
+            continue;
+        }
+
+        argc++;
+        args[argc] = NULL;
+
+        if (runjob(argc, args, opts, pool->nworkers > 1 ? 1 : 0) != EXIT_SUCCESS) {
+            fprintf(stderr, "metang: %s:%zu: job failed\n", pool->path, job->lineno);
+            self->failed = true;
+        }
+    }
+
+    self->failed |= opts == NULL;
+    free(args);
     free(opts);
+    if (self->id > 0) {
+        arena_free(&a);
+    }
+
+    return NULL;
+}
+
+// Run every job listed in a manifest, one per line, as given by `argv`:
+//
+//     batch [-j|--jobs N] <MANIFEST>
+//
+// Each line holds a command and its arguments, as they would be given to
+// `metang` by a shell, quotes included; blank lines and lines starting with
+// `#` are skipped. With N
+// workers, jobs run concurrently and may finish in any order; N = 0 uses one
+// worker per online processor.
+static int batch(int argc, char **argv)
+{
+    long nworkers = 1;
+    if (argc > 2 && (strcmp(argv[0], "-j") == 0 || strcmp(argv[0], "--jobs") == 0)) {
+        str arg = strnew(argv[1], strlen(argv[1]));
+        if (!strtolong(&arg, &nworkers) || nworkers < 0) {
+            fprintf(stderr, "metang: Expected non-negative integer argument for option “%s”, but found “%s”\n", argv[0], argv[1]);
+            return EXIT_FAILURE;
+        }
+
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc != 1) {
+        fprintf(stderr,
+                "metang: Command “batch” requires a manifest file\n\n%s\n\n%s\n",
+                short_usage.buf,
+                commands_section.buf);
+        return EXIT_FAILURE;
+    }
+
+    const char *path = argv[0];
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "metang: could not open manifest file “%s”: %s\n", path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    int exit = EXIT_SUCCESS;
+    jobpool pool = { .path = path };
+    usize count = 0;
+    usize cap = 0;
+    char *line = NULL;
+    usize linecap = 0;
+    for (usize lineno = 1; getline(&line, &linecap, f) != -1; lineno++) {
+        usize skip = strspn(line, " \t\r\n");
+        if (line[skip] == '\0' || line[skip] == '#') {
+            continue;
+        }
+
+        if (count == cap) {
+            cap = cap ? cap * 2 : 64;
+            batchjob *tjobs = realloc(pool.jobs, cap * sizeof(batchjob));
+            if (tjobs == NULL) {
+                fprintf(stderr, "metang: %s:%zu: out of memory\n", path, lineno);
+                exit = EXIT_FAILURE;
+                break;
+            }
+
+            pool.jobs = tjobs;
+        }
+
+        // The job keeps this buffer; the next line is read into a new one.
+        pool.jobs[count++] = (batchjob){ .line = line, .lineno = lineno };
+        line = NULL;
+        linecap = 0;
+    }
+
+    free(line);
+    fclose(f);
+
+    if (nworkers == 0) {
+        nworkers = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    // There is no use for more workers than there are jobs.
+    pool.nworkers = nworkers < 1 ? 1 : (usize)nworkers;
+    pool.nworkers = count > 0 && pool.nworkers > count ? count : pool.nworkers;
+    pool.queues = calloc(pool.nworkers, sizeof(jobqueue));
+    worker *workers = calloc(pool.nworkers, sizeof(worker));
+    if (exit != EXIT_SUCCESS || pool.queues == NULL || workers == NULL) {
+        exit = EXIT_FAILURE;
+        goto cleanup;
+    }
+
+    for (usize i = 0; i < pool.nworkers; i++) {
+        pthread_mutex_init(&pool.queues[i].lock, NULL);
+        pool.queues[i].head = count * i / pool.nworkers;
+        pool.queues[i].tail = count * (i + 1) / pool.nworkers;
+        workers[i] = (worker){ .pool = &pool, .id = i };
+    }
+
+    // A worker which cannot be started leaves its jobs to be stolen.
+    for (usize i = 1; i < pool.nworkers; i++) {
+        workers[i].started = pthread_create(&workers[i].thread, NULL, work, &workers[i]) == 0;
+    }
+
+    work(&workers[0]);
+    for (usize i = 0; i < pool.nworkers; i++) {
+        if (workers[i].started) {
+            pthread_join(workers[i].thread, NULL);
+        }
+
+        exit = workers[i].failed ? EXIT_FAILURE : exit;
+    }
+
+    for (usize i = 0; i < pool.nworkers; i++) {
+        pthread_mutex_destroy(&pool.queues[i].lock);
+    }
+
+cleanup:
+    for (usize i = 0; i < count; i++) {
+        free(pool.jobs[i].line);
+    }
+
+    free(pool.jobs);
+    free(pool.queues);
+    free(workers);
     return exit;
 }
 
+static volatile sig_atomic_t stopping;
+
+static void stop(int sig)
+{
+    stopping = 1;
+}
+
+// Run one job for a client. A failure which escapes the job lands here, rather
+// than in a frame left behind by an earlier job.
+static int dispatch(int argc, char **argv, options *opts)
+{
+    if (setjmp(global->env)) {
+        return EXIT_FAILURE;
+    }
+
+    return argc > 1 && strcmp(argv[1], "batch") == 0
+        ? batch(argc - 2, argv + 2)
+        : run(argc, argv, opts, 0);
+}
+
+// Run jobs sent by clients, one at a time. Each job runs with the client's
+// standard streams and working directory in place of the server's own, so
+// that its output is indistinguishable from that of a local run. The arena,
+// compiled templates, and mapped inputs all stay warm between jobs.
+static int serve(int argc, char **argv)
+{
+    if (argc != 2 || (strcmp(argv[0], "-s") != 0 && strcmp(argv[0], "--socket") != 0)) {
+        fprintf(stderr,
+                "metang: Command “serve” requires a socket path, given by --socket <PATH>\n\n%s\n\n%s\n",
+                short_usage.buf,
+                commands_section.buf);
+        return EXIT_FAILURE;
+    }
+
+    const char *path = argv[1];
+    int sock = srvlisten(path);
+    if (sock < 0) {
+        return EXIT_FAILURE;
+    }
+
+    // Interrupting the server stops it between jobs. Without SA_RESTART, a
+    // signal breaks the wait for the next client.
+    struct sigaction sa = { .sa_handler = stop };
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    // Without these, the server could not put its own streams and working
+    // directory back after a job, and the next job would inherit the last.
+    int home[NUM_REQ_FDS] = {
+        [REQ_STDIN] = dup(STDIN_FILENO),
+        [REQ_STDOUT] = dup(STDOUT_FILENO),
+        [REQ_STDERR] = dup(STDERR_FILENO),
+        [REQ_CWD] = open(".", O_RDONLY | O_DIRECTORY),
+    };
+
+    bool homed = true;
+    for (int i = 0; i < NUM_REQ_FDS; i++) {
+        homed = homed && home[i] >= 0;
+    }
+
+    options *opts = homed ? malloc(sizeof(*opts)) : NULL;
+    kept = homed ? calloc(MAX_KEPT_INPUTS, sizeof(keptinput)) : NULL;
+    if (!homed || !opts || !kept) {
+        fprintf(stderr, "metang: could not start server: %s\n", strerror(errno));
+    }
+
+    request req;
+    while (opts && kept && homed && !stopping && srvaccept(sock, &req)) {
+        bool lent = true;
+        for (int fd = STDIN_FILENO; fd <= STDERR_FILENO; fd++) {
+            lent = dup2(req.fds[fd], fd) >= 0 && lent;
+        }
+
+        int exit = EXIT_FAILURE;
+        if (lent && fchdir(req.fds[REQ_CWD]) == 0) {
+            scratch s;
+            scratch_begin(&s, global);
+            exit = dispatch(req.argc, req.argv, opts);
+            scratch_end(&s);
+        }
+
+        fflush(stdout);
+        fflush(stderr);
+        clearerr(stdin);
+
+        for (int fd = STDIN_FILENO; fd <= STDERR_FILENO; fd++) {
+            homed = dup2(home[fd], fd) >= 0 && homed;
+        }
+
+        homed = fchdir(home[REQ_CWD]) == 0 && homed;
+        if (!homed) {
+            fprintf(stderr, "metang: could not restore the server's own streams or directory: %s\n", strerror(errno));
+        }
+
+        srvreply(&req, exit);
+    }
+
+    for (usize i = 0; kept && i < MAX_KEPT_INPUTS; i++) {
+        if (kept[i].text.buf) {
+            munmap(kept[i].text.buf, kept[i].text.len);
+        }
+    }
+
+    for (int i = 0; i < NUM_REQ_FDS; i++) {
+        if (home[i] >= 0) {
+            close(home[i]);
+        }
+    }
+
+    free(kept);
+    free(opts);
+    close(sock);
+    unlink(path);
+    return stopping && homed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 #define PARGV_EXIT_SUCCESS EXIT_SUCCESS + 1
 #define PARGV_EXIT_FAILURE EXIT_FAILURE + 1
 
@@ -192,108 +713,143 @@ static int pargv(int *argc, char ***argv, options *opts)
     return EXIT_SUCCESS;
 }
 
-static str fload(FILE *f)
+// Check whether the job in `argv` would wait on a standard input which might
+// never end, e.g. a pipe or a terminal. Forwarded, such a job would hold up the
+// server for every other client, so it runs locally instead. Jobs which name
+// an input file, or whose options are invalid, never read standard input.
+static bool waitsonstdin(int argc, char **argv)
 {
-    usize read;
-    char buf[1 << 15];
+    struct stat st;
+    if (fstat(STDIN_FILENO, &st) == 0
+        && (S_ISREG(st.st_mode) || (S_ISCHR(st.st_mode) && !isatty(STDIN_FILENO)))) {
+        return false;
+    }
 
-    // The arena's internal memory can change during successive claims, so we
-    // must track the expected starting position.
-    usize bufofs = nextofs(global, alignof(char));
-    usize buflen = 0;
-    while ((read = fread(buf, 1, 1 << 15, f)) != 0) {
-        claim(global, buf, strlen(buf), A_F_EXTEND);
-        buflen += read;
+    if (argc < 2 || (strcmp(argv[1], "enum") != 0 && strcmp(argv[1], "mask") != 0)) {
+        return false;
     }
 
-    str s = strnew(global->mem + bufofs, buflen);
-    return s;
+    options opts = { .mode = strcmp(argv[1], "enum") == 0 ? OPTS_M_ENUM : OPTS_M_MASK };
+    argc -= 2;
+    argv += 2;
+    return parseopts(&argc, &argv, &opts) && opts.infile.len == 0;
 }
 
-static inline usize max_of(usize a, usize b)
+// Check that the file described by `a` has not been written by the time it is
+// described by `b`. Anyone may set back a modification time, but no one may
+// set back a status change time, which any write also advances.
+static bool unmodified(const struct stat *a, const struct stat *b)
 {
-    return a > b ? a : b;
+    return a->st_size == b->st_size
+        && a->st_mtim.tv_sec == b->st_mtim.tv_sec
+        && a->st_mtim.tv_nsec == b->st_mtim.tv_nsec
+        && a->st_ctim.tv_sec == b->st_ctim.tv_sec
+        && a->st_ctim.tv_nsec == b->st_ctim.tv_nsec;
 }
 
-static inline usize assign_strlen(isize i)
+// Find the kept input which matches `st`, or else claim a slot for it, in
+// which case the slot's text is empty. A slot which held an older version of
+// the same file is reused before any other.
+static keptinput *keep(const struct stat *st)
 {
-    int r = 1 + (i < 0);
-    usize n = (i < 0) ? -i : i;
-    while (n > 9) {
-        n /= 10;
-        r++;
+    keptinput *slot = NULL;
+    for (usize i = 0; i < MAX_KEPT_INPUTS; i++) {
+        if (kept[i].st.st_dev == st->st_dev && kept[i].st.st_ino == st->st_ino && kept[i].text.buf) {
+            if (unmodified(&kept[i].st, st)) {
+                return &kept[i];
+            }
+
+            slot = &kept[i];
+            break;
+        }
+    }
+
+    if (slot == NULL) {
+        slot = &kept[kept_next];
+        kept_next = (kept_next + 1) % MAX_KEPT_INPUTS;
+    }
+
+    if (slot->text.buf) {
+        munmap(slot->text.buf, slot->text.len);
     }
 
-    return r;
+    *slot = (keptinput){ .st = *st };
+    return slot;
 }
 
-static enumerator *enumerate(FILE *f, options *opts)
+static str fload(FILE *f)
 {
-    strpair pair = {0};
-    strpair line = {0};
-    line.tail = fload(f);
-
-    enumerator *head = NULL;
-    enumerator **tail = &head;
-    isize val = opts->start;
-    for (usize i = 0; i < opts->prepend_count; i++) {
-        *tail = new (global, enumerator, 1, A_F_ZERO | A_F_EXTEND);
-        (*tail)->next = NULL;
-        (*tail)->ident = opts->prepend[i];
-        (*tail)->assignment = val;
-        val++;
-
-        head->max_ident_len = max_of((*tail)->ident.len, head->max_ident_len);
-        head->max_assign_len = max_of(assign_strlen((*tail)->assignment), head->max_assign_len);
-        head->count++;
-
-        tail = &(*tail)->next;
-    }
-
-    while (line.tail.len) {
-        line = strcut(&line.tail, '\n');
-        pair = strcut(&line.head, '#');
-        pair = strcut(&pair.head, '=');
-        pair.head.len = strtrim(&pair.head);
-        if (pair.tail.len > 0) {
-            if (opts->mode == OPTS_M_MASK) {
-                fprintf(stderr,
-                        "metang: Per-value assignments are not permitted for bitmasks\n");
-                longjmp(global->env, 1);
-            } else if (!strtolong(&pair.tail, &val)) {
-                fprintf(stderr,
-                        "metang: Expected numeric value for assignment, but found “%s”\n",
-                        pair.tail.buf);
-                longjmp(global->env, 1);
-            }
+    // Regular files are mapped and read in place.
+    struct stat st;
+    int fd = fileno(f);
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        keptinput *slot = kept ? keep(&st) : NULL;
+        if (slot && slot->text.buf) {
+            source = slot->text;
+            source_kept = true;
+            return source;
         }
 
-        *tail = new (global, enumerator, 1, A_F_ZERO | A_F_EXTEND);
-        (*tail)->next = NULL;
-        (*tail)->ident = pair.head;
-        (*tail)->assignment = val;
-        val++;
+        // A file written between the two calls to `fstat` may have been mapped
+        // part-way through the change, so it is read instead.
+        struct stat now;
+        char *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED && (fstat(fd, &now) != 0 || !unmodified(&st, &now))) {
+            munmap(map, st.st_size);
+            map = MAP_FAILED;
+        }
 
-        head->max_ident_len = max_of((*tail)->ident.len, head->max_ident_len);
-        head->max_assign_len = max_of(assign_strlen((*tail)->assignment), head->max_assign_len);
-        head->count++;
+        if (map != MAP_FAILED) {
+            posix_madvise(map, st.st_size, POSIX_MADV_SEQUENTIAL);
+            source = strnew(map, st.st_size);
+            source_mapped = slot == NULL;
+            source_kept = slot != NULL;
+            if (slot) {
+                slot->text = source;
+            }
 
-        tail = &(*tail)->next;
+            return source;
+        }
     }
 
-    for (usize i = 0; i < opts->append_count; i++) {
-        *tail = new (global, enumerator, 1, A_F_ZERO | A_F_EXTEND);
-        (*tail)->next = NULL;
-        (*tail)->ident = opts->append[i];
-        (*tail)->assignment = val;
-        val++;
+    // Anything else, e.g. a pipe, is streamed into a growing buffer.
+    usize read;
+    usize cap = 1 << 15;
+    usize len = 0;
+    char *buf = malloc(cap);
+    while (buf && (read = fread(buf + len, 1, cap - len, f)) != 0) {
+        len += read;
+        if (len == cap) {
+            char *tbuf = realloc(buf, cap * 2);
+            if (tbuf == NULL) {
+                break;
+            }
 
-        head->max_ident_len = max_of((*tail)->ident.len, head->max_ident_len);
-        head->max_assign_len = max_of(assign_strlen((*tail)->assignment), head->max_assign_len);
-        head->count++;
+            buf = tbuf;
+            cap *= 2;
+        }
+    }
 
-        tail = &(*tail)->next;
+    source = strnew(buf, len);
+    source_mapped = false;
+    if (buf == NULL || !feof(f)) {
+        fprintf(stderr, "metang: could not read input file\n");
+        longjmp(global->env, 1);
+    }
+
+    return source;
+}
+
+static void funload(void)
+{
+    // Kept inputs are unmapped by the server, once they are replaced.
+    if (source_mapped) {
+        munmap(source.buf, source.len);
+    } else if (!source_kept) {
+        free(source.buf);
     }
 
-    return head;
+    source = (str){0};
+    source_mapped = false;
+    source_kept = false;
 }
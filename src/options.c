@@ -10,7 +10,7 @@
 typedef struct opthandler {
     str longopt;
     char shortopt;
-    bool has_arg : 8;
+    bool has_arg : 1;
     u32 mode     : 16;
     bool (*handler)(options *opts, str *arg);
 } opthandler;
@@ -20,6 +20,11 @@ typedef struct opterrmsg {
     usize argc;
 } opterrmsg;
 
+typedef struct optvalue {
+    str name;
+    u32 value;
+} optvalue;
+
 static bool handle_append(options *opts, str *arg);
 static bool handle_prepend(options *opts, str *arg);
 static bool handle_start_from(options *opts, str *arg);
@@ -28,6 +33,11 @@ static bool handle_leader(options *opts, str *arg);
 static bool handle_tag_name(options *opts, str *arg);
 static bool handle_guard(options *opts, str *arg);
 static bool handle_lang(options *opts, str *arg);
+static bool handle_index(options *opts, str *arg);
+static bool handle_layout(options *opts, str *arg);
+static bool handle_source(options *opts, str *arg);
+static bool handle_py_style(options *opts, str *arg);
+static bool handle_cache_dir(options *opts, str *arg);
 
 // clang-format off
 static const opthandler opthandlers[] = {
@@ -39,17 +49,50 @@ static const opthandler opthandlers[] = {
     { strnew("tag-name"),        't', true,  OPTS_M_ANY,  handle_tag_name        },
     { strnew("guard"),           'G', true,  OPTS_M_ANY,  handle_guard           },
     { strnew("lang"),            'L', true,  OPTS_M_ANY,  handle_lang            },
+    { strnew("index"),           'i', true,  OPTS_M_ANY,  handle_index           },
+    { strnew("layout"),          'T', true,  OPTS_M_ANY,  handle_layout          },
+    { strnew("source"),          's', true,  OPTS_M_ANY,  handle_source          },
+    { strnew("py-style"),        'P', true,  OPTS_M_ANY,  handle_py_style        },
+    { strnew("cache-dir"),       'C', true,  OPTS_M_ANY,  handle_cache_dir       },
     { strZ,                      ' ', false, OPTS_M_NONE, NULL                   }, // must ALWAYS be last!
 };
 
 static const opterrmsg errmsg[] = {
-    [OPTS_S]                     = { strZ,                                                                          0 },
-    [OPTS_F_UNRECOGNIZED_OPT]    = { strnew("Unrecognized option “%s”"),                                            1 },
-    [OPTS_F_OPT_MISSING_ARG]     = { strnew("Option “%s” missing argument"),                                        1 },
-    [OPTS_F_TOO_MANY_APPENDS]    = { strnew("Too many “--append” options; limit: 16"),                              0 },
-    [OPTS_F_TOO_MANY_PREPENDS]   = { strnew("Too many “--prepend” options; limit: 16"),                             0 },
-    [OPTS_F_NOT_AN_INTEGER]      = { strnew("Expected integer argument for option “%s”, but found “%s”"),           2 },
-    [OPTS_F_UNRECOGNIZED_LANG]   = { strnew("Unexpected value for option “%s” argument “%s”"),                      2 },
+    [OPTS_S]                       = { strZ,                                                                                                0 },
+    [OPTS_F_UNRECOGNIZED_OPT]      = { strnew("Unrecognized option “%s”"),                                                                  1 },
+    [OPTS_F_OPT_MISSING_ARG]       = { strnew("Option “%s” missing argument"),                                                              1 },
+    [OPTS_F_TOO_MANY_APPENDS]      = { strnew("Too many “--append” options; limit: 16"),                                                    0 },
+    [OPTS_F_TOO_MANY_PREPENDS]     = { strnew("Too many “--prepend” options; limit: 16"),                                                   0 },
+    [OPTS_F_NOT_AN_INTEGER]        = { strnew("Expected integer argument for option “%s”, but found “%s”"),                                 2 },
+    [OPTS_F_UNRECOGNIZED_LANG]     = { strnew("Unexpected value for option “%s” argument “%s”"),                                            2 },
+    [OPTS_F_UNRECOGNIZED_INDEX]    = { strnew("Unexpected value for option “%s” argument “%s”"),                                            2 },
+    [OPTS_F_UNRECOGNIZED_LAYOUT]   = { strnew("Unexpected value for option “%s” argument “%s”"),                                            2 },
+    [OPTS_F_SOURCE_WITHOUT_OUTPUT] = { strnew("Option “--source” requires option “--output”"),                                              0 },
+    [OPTS_F_UNRECOGNIZED_PY_STYLE] = { strnew("Unexpected value for option “%s” argument “%s”"),                                            2 },
+    [OPTS_F_TOO_MANY_TARGETS]      = { strnew("Too many languages or outputs; limit: 8"),                                                   0 },
+    [OPTS_F_OUTPUT_PER_TARGET]     = { strnew("Option “--lang” lists more than one language; give one “--output” for each"),                0 },
+};
+
+static const optvalue indexes[] = {
+    { strnew("hash"),            OPTS_I_HASH    },
+    { strnew("bsearch"),         OPTS_I_BSEARCH },
+    { strnew("reverse"),         OPTS_I_REVERSE },
+    { strnew("switch"),          OPTS_I_SWITCH  },
+    { strZ,                      OPTS_I_NONE    }, // must ALWAYS be last!
+};
+
+static const optvalue layouts[] = {
+    { strnew("aos"),             OPTS_T_AOS     },
+    { strnew("pool"),            OPTS_T_POOL    },
+    { strnew("soa"),             OPTS_T_SOA     },
+    { strZ,                      OPTS_T_AOS     }, // must ALWAYS be last!
+};
+
+static const optvalue py_styles[] = {
+    { strnew("class"),           OPTS_P_CLASS   },
+    { strnew("const"),           OPTS_P_CONST   },
+    { strnew("lazy"),            OPTS_P_LAZY    },
+    { strZ,                      OPTS_P_CLASS   }, // must ALWAYS be last!
 };
 // clang-format on
 
@@ -87,11 +130,21 @@ static inline void initopts(options *opts)
     opts->guard = strnew("METANG");
     opts->outfile = strZ;
     opts->infile = strZ;
+    opts->srcfile = strZ;
+    opts->cachedir = strZ;
 
     opts->flags = false;
 
     opts->lang = strnew("c");
     opts->genf = 0;
+    opts->targets[0] = 0;
+    opts->target_count = 1;
+    opts->outfile_count = 0;
+
+    opts->index = OPTS_I_NONE;
+    opts->threads = 0;
+    opts->layout = OPTS_T_AOS;
+    opts->py_style = OPTS_P_CLASS;
 }
 
 bool parseopts(int *argc, char ***argv, options *opts)
@@ -139,6 +192,23 @@ bool parseopts(int *argc, char ***argv, options *opts)
         opts->infile = opt;
     }
 
+    // A single target keeps the last output given. Otherwise, each target needs
+    // an output of its own, or all of them are written to standard output in
+    // turn.
+    if (opts->target_count == 1 && opts->outfile_count > 1) {
+        opts->outfiles[0] = opts->outfile;
+        opts->outfile_count = 1;
+    } else if (opts->target_count > 1 && opts->outfile_count != 0 && opts->outfile_count != opts->target_count) {
+        opts->result = OPTS_F_OUTPUT_PER_TARGET;
+        return false;
+    }
+
+    // The generated source includes the generated header by name.
+    if (opts->srcfile.len > 0 && opts->outfile.len == 0) {
+        opts->result = OPTS_F_SOURCE_WITHOUT_OUTPUT;
+        return false;
+    }
+
     // `tag` must be post-processed if it does not yet have a value.
     if (opts->tag.len == 0) {
         opts->tag = opts->infile.len == 0
@@ -207,8 +277,15 @@ static bool handle_start_from(options *opts, str *arg)
 
 static bool handle_output(options *opts, str *arg)
 {
-    opts->outfile = strnewp(arg);
-    return true;
+    if (opts->outfile_count < MAX_TARGETS) {
+        opts->outfile = strnewp(arg);
+        opts->outfiles[opts->outfile_count] = opts->outfile;
+        opts->outfile_count++;
+        return true;
+    }
+
+    opts->result = OPTS_F_TOO_MANY_TARGETS;
+    return false;
 }
 
 static bool handle_leader(options *opts, str *arg)
@@ -232,16 +309,86 @@ static bool handle_guard(options *opts, str *arg)
     return true;
 }
 
+// A later `--lang` replaces the whole list given by an earlier one.
 static bool handle_lang(options *opts, str *arg)
 {
-    for (usize i = 0; generators[i].lang.len > 0; i++) {
-        if (streq(&generators[i].lang, arg)) {
-            opts->lang = strnewp(arg);
-            opts->genf = i;
+    opts->lang = strnewp(arg);
+    opts->target_count = 0;
+
+    strpair pair = { .tail = *arg };
+    do {
+        pair = strcut(&pair.tail, ',');
+
+        usize i = 0;
+        while (generators[i].lang.len > 0 && !streq(&generators[i].lang, &pair.head)) {
+            i++;
+        }
+
+        if (generators[i].lang.len == 0) {
+            opts->result = OPTS_F_UNRECOGNIZED_LANG;
+            return false;
+        }
+
+        if (opts->target_count == MAX_TARGETS) {
+            opts->result = OPTS_F_TOO_MANY_TARGETS;
+            return false;
+        }
+
+        opts->targets[opts->target_count] = i;
+        opts->target_count++;
+    } while (pair.tail.len > 0);
+
+    opts->genf = opts->targets[0];
+    return true;
+}
+
+static bool handle_index(options *opts, str *arg)
+{
+    for (usize i = 0; indexes[i].name.len > 0; i++) {
+        if (streq(&indexes[i].name, arg)) {
+            opts->index |= indexes[i].value;
+            return true;
+        }
+    }
+
+    opts->result = OPTS_F_UNRECOGNIZED_INDEX;
+    return false;
+}
+
+static bool handle_source(options *opts, str *arg)
+{
+    opts->srcfile = strnewp(arg);
+    return true;
+}
+
+static bool handle_layout(options *opts, str *arg)
+{
+    for (usize i = 0; layouts[i].name.len > 0; i++) {
+        if (streq(&layouts[i].name, arg)) {
+            opts->layout = layouts[i].value;
+            return true;
+        }
+    }
+
+    opts->result = OPTS_F_UNRECOGNIZED_LAYOUT;
+    return false;
+}
+
+static bool handle_py_style(options *opts, str *arg)
+{
+    for (usize i = 0; py_styles[i].name.len > 0; i++) {
+        if (streq(&py_styles[i].name, arg)) {
+            opts->py_style = py_styles[i].value;
             return true;
         }
     }
 
-    opts->result = OPTS_F_UNRECOGNIZED_LANG;
+    opts->result = OPTS_F_UNRECOGNIZED_PY_STYLE;
     return false;
 }
+
+static bool handle_cache_dir(options *opts, str *arg)
+{
+    opts->cachedir = strnewp(arg);
+    return true;
+}
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "outbuf.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "alloc.h"
+
+outbuf obnew(arena *a, usize cap)
+{
+    return (outbuf){
+        .a = a,
+        .buf = new (a, char, cap, A_F_EXTEND),
+        .len = 0,
+        .cap = cap,
+    };
+}
+
+// Ensure that at least `n` more bytes fit in the buffer.
+static void reserve(outbuf *ob, usize n)
+{
+    if (ob->len + n <= ob->cap) {
+        return;
+    }
+
+    usize tcap = ob->cap * 2 > ob->len + n ? ob->cap * 2 : ob->len + n;
+
+    // If nothing has been allocated since the buffer, then it may be able to
+    // grow without moving.
+    arena *a = ob->a;
+    if (ob->buf + ob->cap == a->mem + a->ofs
+        && alloc(a, sizeof(char), alignof(char), tcap - ob->cap, A_F_SOFT_FAIL) == ob->buf + ob->cap) {
+        ob->cap = tcap;
+        return;
+    }
+
+    char *tbuf = new (a, char, tcap, A_F_EXTEND);
+    memcpy(tbuf, ob->buf, ob->len);
+    ob->buf = tbuf;
+    ob->cap = tcap;
+}
+
+void obwrite(outbuf *ob, const char *s, usize len)
+{
+    reserve(ob, len);
+    memcpy(ob->buf + ob->len, s, len);
+    ob->len += len;
+}
+
+void obputs(outbuf *ob, const char *s)
+{
+    obwrite(ob, s, strlen(s));
+}
+
+void obstr(outbuf *ob, const str *s)
+{
+    obwrite(ob, s->buf, s->len);
+}
+
+void obpad(outbuf *ob, char c, usize n)
+{
+    reserve(ob, n);
+    memset(ob->buf + ob->len, c, n);
+    ob->len += n;
+}
+
+usize intlen(isize v)
+{
+    usize r = 1 + (v < 0);
+    usize n = v < 0 ? -(usize)v : (usize)v;
+    while (n > 9) {
+        n /= 10;
+        r++;
+    }
+
+    return r;
+}
+
+void obint(outbuf *ob, isize v, usize width)
+{
+    usize len = intlen(v);
+    usize pad = width > len ? width - len : 0;
+    reserve(ob, pad + len);
+
+    char *p = ob->buf + ob->len;
+    memset(p, ' ', pad);
+    p += pad;
+
+    // Digits are written back-to-front, from the end of the field.
+    usize n = v < 0 ? -(usize)v : (usize)v;
+    char *q = p + len;
+    do {
+        *--q = '0' + n % 10;
+        n /= 10;
+    } while (n > 0);
+
+    if (v < 0) {
+        *p = '-';
+    }
+
+    ob->len += pad + len;
+}
+
+// Write all of `len` bytes from `buf` to `fd`, retrying after interruptions
+// and short writes.
+static bool writeall(int fd, const char *buf, usize len)
+{
+    usize done = 0;
+    while (done < len) {
+        ssize_t n = write(fd, buf + done, len - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n < 0) {
+            return false;
+        }
+
+        done += n;
+    }
+
+    return true;
+}
+
+bool obflush(outbuf *ob, FILE *f)
+{
+    // Holding the stream's lock keeps this output in one piece when several
+    // threads share a stream, e.g. standard output in a parallel batch.
+    flockfile(f);
+
+    // Anything already buffered by the stream must precede this output.
+    bool ok = fflush(f) == 0 && writeall(fileno(f), ob->buf, ob->len);
+
+    funlockfile(f);
+    if (ok) {
+        ob->len = 0;
+    }
+
+    return ok;
+}
+
+// Check whether `path` names a regular file which holds exactly the contents
+// of the buffer.
+static bool unchanged(const outbuf *ob, const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode) || (usize)st.st_size != ob->len) {
+        return false;
+    }
+
+    if (ob->len == 0) {
+        return true;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    // The file is read rather than mapped, so that one truncated while it is
+    // compared reads short and miscompares instead of faulting.
+    char buf[1 << 14];
+    usize done = 0;
+    while (done < ob->len) {
+        usize want = ob->len - done < sizeof(buf) ? ob->len - done : sizeof(buf);
+        ssize_t n = pread(fd, buf, want, done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n <= 0 || memcmp(buf, ob->buf + done, n) != 0) {
+            break;
+        }
+
+        done += n;
+    }
+
+    close(fd);
+    return done == ob->len;
+}
+
+// Temporary files are named for the process and a sequence number, so that
+// concurrent jobs never collide.
+static atomic_uint tmpseq;
+
+// Replace the file at `path` by writing a temporary file beside it, then
+// renaming it into place. The replacement takes the permissions of `orig`, the
+// file that it replaces, if given; otherwise, it is created subject to the
+// umask. Neither the owner nor any other hard links of `orig` carry over. If
+// `sync` is set, then the contents reach the disk before the rename does, so
+// that a crash cannot leave a truncated file under `path`.
+static bool replace(const outbuf *ob, const char *path, const struct stat *orig, bool sync)
+{
+    usize len = strlen(path) + 48;
+    char *tmp = malloc(len);
+    if (tmp == NULL) {
+        return false;
+    }
+
+    snprintf(tmp, len, "%s.%ld.%u.tmp", path, (long)getpid(), atomic_fetch_add(&tmpseq, 1));
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    bool ok = fd >= 0 && (orig == NULL || fchmod(fd, orig->st_mode & 07777) == 0);
+    ok = ok && writeall(fd, ob->buf, ob->len);
+    ok = ok && (!sync || fsync(fd) == 0);
+    ok = fd >= 0 && close(fd) == 0 && ok;
+    ok = ok && rename(tmp, path) == 0;
+    if (!ok && fd >= 0) {
+        int err = errno;
+        unlink(tmp);
+        errno = err;
+    }
+
+    free(tmp);
+    return ok;
+}
+
+bool obcommit(outbuf *ob, const outdest *dest)
+{
+    // Committing empties the buffer, so the copy is stored first. A cache entry
+    // is trusted by later runs as it stands, so it must be whole if present.
+    if (dest->cache != NULL) {
+        replace(ob, dest->cache, NULL, true);
+    }
+
+    if (dest->mem != NULL) {
+        char *copy = new (dest->mem, char, ob->len + 1, A_F_EXTEND | A_F_SOFT_FAIL);
+        if (copy == NULL) {
+            return false;
+        }
+
+        memcpy(copy, ob->buf, ob->len);
+        copy[ob->len] = '\0';
+        *dest->text = strnew(copy, ob->len);
+        ob->len = 0;
+        return true;
+    }
+
+    if (dest->path == NULL) {
+        return obflush(ob, dest->stream);
+    }
+
+    // Only a regular file, or nothing at all, is replaced by renaming over it.
+    // Anything else, e.g. a symbolic link or /dev/stdout, is written through in
+    // place, so that whatever it refers to receives the output.
+    bool ok = true;
+    if (!unchanged(ob, dest->path)) {
+        struct stat st;
+        if (lstat(dest->path, &st) != 0) {
+            ok = errno == ENOENT && replace(ob, dest->path, NULL, false);
+        } else if (S_ISREG(st.st_mode)) {
+            ok = replace(ob, dest->path, &st, false);
+        } else {
+            int fd = open(dest->path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+            ok = fd >= 0 && writeall(fd, ob->buf, ob->len);
+            ok = fd >= 0 && close(fd) == 0 && ok;
+        }
+    }
+
+    if (!ok) {
+        fprintf(stderr,
+                "metang: could not write output file “%s”: %s\n",
+                dest->path, strerror(errno));
+        return false;
+    }
+
+    ob->len = 0;
+    return true;
+}
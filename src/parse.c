@@ -0,0 +1,128 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "parse.h"
+
+#include <limits.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "outbuf.h"
+#include "strbuf.h"
+
+// Each flag of a mask takes a bit of its value, and the union of all of them
+// must still be positive.
+#define MASK_MAX_FLAGS (sizeof(isize) * CHAR_BIT - 1)
+
+static inline usize max_of(usize a, usize b)
+{
+    return a > b ? a : b;
+}
+
+// Append a member to the columns of `e`, growing them if they are full.
+static void push(arena *a, enumerator *e, const str *ident, isize assignment)
+{
+    if (e->count == e->cap) {
+        usize cap = e->cap ? e->cap * 2 : 64;
+        str *names = new (a, str, cap, A_F_EXTEND);
+        isize *assignments = new (a, isize, cap, A_F_EXTEND);
+        memcpy(names, e->names, e->count * sizeof(str));
+        memcpy(assignments, e->assignments, e->count * sizeof(isize));
+        e->names = names;
+        e->assignments = assignments;
+        e->cap = cap;
+    }
+
+    char *buf = new (a, char, ident->len + 1, A_F_EXTEND);
+    e->names[e->count] = strsnake(ident, buf, NULL, S_SNAKE_F_UPPER);
+    e->assignments[e->count] = assignment;
+    e->max_ident_len = max_of(ident->len, e->max_ident_len);
+    e->max_assign_len = max_of(intlen(assignment), e->max_assign_len);
+    e->count++;
+}
+
+enumerator *enumerate(arena *a, str text, const options *opts)
+{
+    strpair pair = {0};
+    strpair line = {0};
+    line.tail = text;
+
+    // Size the columns for one member per line, so that they need not grow.
+    usize lines = 1;
+    for (const char *p = line.tail.buf; (p = memchr(p, '\n', line.tail.buf + line.tail.len - p)); p++) {
+        lines++;
+    }
+
+    enumerator *e = new (a, enumerator, 1, A_F_ZERO | A_F_EXTEND);
+    e->cap = opts->prepend_count + lines + opts->append_count;
+    e->names = new (a, str, e->cap, A_F_EXTEND);
+    e->assignments = new (a, isize, e->cap, A_F_EXTEND);
+
+    isize val = opts->start;
+    for (usize i = 0; i < opts->prepend_count; i++) {
+        push(a, e, &opts->prepend[i], val);
+        val++;
+    }
+
+    while (line.tail.len) {
+        line = strcut(&line.tail, '\n');
+        pair = strcut(&line.head, '#');
+        pair = strcut(&pair.head, '=');
+        pair.head.len = strtrim(&pair.head);
+        // Blank and comment-only lines name no member and take no value.
+        if (pair.head.len == 0 && pair.tail.len == 0) {
+            continue;
+        }
+
+        if (pair.tail.len > 0) {
+            if (opts->mode == OPTS_M_MASK) {
+                fprintf(stderr,
+                        "metang: Per-value assignments are not permitted for bitmasks\n");
+                longjmp(a->env, 1);
+            } else if (!strtolong(&pair.tail, &val)) {
+                fprintf(stderr,
+                        "metang: Expected numeric value for assignment, but found “%.*s”\n",
+                        (int)pair.tail.len, pair.tail.buf);
+                longjmp(a->env, 1);
+            }
+        }
+
+        push(a, e, &pair.head, val);
+        val++;
+    }
+
+    for (usize i = 0; i < opts->append_count; i++) {
+        push(a, e, &opts->append[i], val);
+        val++;
+    }
+
+    if (e->count == 0) {
+        fprintf(stderr, "metang: input “%s” defines no members\n", opts->infile.buf);
+        longjmp(a->env, 1);
+    }
+
+    // A mask's members are its flags, between the `NONE` and `ANY` added to it.
+    if (opts->mode == OPTS_M_MASK && e->count - 2 > MASK_MAX_FLAGS) {
+        fprintf(stderr,
+                "metang: Bitmasks may hold at most %zu flags, but found %zu\n",
+                (usize)MASK_MAX_FLAGS, (usize)(e->count - 2));
+        longjmp(a->env, 1);
+    }
+
+    return e;
+}
@@ -0,0 +1,331 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "serve.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Requests are framed as a 32-bit length, sent along with the lent descriptors,
+// followed by that many bytes of NUL-terminated arguments. The reply is the
+// exit status, as a single byte.
+#define MAX_REQUEST_LEN (1 << 20)
+
+// A client which stalls partway through a request would otherwise hold up
+// every other, so a request is dropped once any read for it waits this long.
+#define REQUEST_TIMEOUT_SEC 5
+
+static bool sockaddr(const char *path, struct sockaddr_un *addr)
+{
+    *addr = (struct sockaddr_un){ .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
+static bool sendall(int fd, const void *buf, usize len)
+{
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n <= 0) {
+            return false;
+        }
+
+        p += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+static bool recvall(int fd, void *buf, usize len)
+{
+    char *p = buf;
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n <= 0) {
+            return false;
+        }
+
+        p += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+static int dial(const char *path)
+{
+    struct sockaddr_un addr;
+    if (!sockaddr(path, &addr)) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+
+    return fd;
+}
+
+int srvlisten(const char *path)
+{
+    struct sockaddr_un addr;
+    if (!sockaddr(path, &addr)) {
+        fprintf(stderr, "metang: could not listen on socket “%s”: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int live = dial(path);
+    if (live >= 0) {
+        close(live);
+        fprintf(stderr, "metang: a server is already listening on socket “%s”\n", path);
+        return -1;
+    }
+
+    // Only a stale socket is replaced; anything else at `path` is left be.
+    struct stat st;
+    if (lstat(path, &st) == 0 && !S_ISSOCK(st.st_mode)) {
+        fprintf(stderr, "metang: could not listen on socket “%s”: not a socket\n", path);
+        return -1;
+    }
+
+    unlink(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0
+        || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || listen(fd, SOMAXCONN) != 0) {
+        fprintf(stderr, "metang: could not listen on socket “%s”: %s\n", path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        return -1;
+    }
+
+    return fd;
+}
+
+static void release(request *req)
+{
+    for (int i = 0; i < NUM_REQ_FDS; i++) {
+        if (req->fds[i] >= 0) {
+            close(req->fds[i]);
+        }
+    }
+
+    close(req->conn);
+    free(req->argv);
+    free(req->args);
+    *req = (request){ .conn = -1 };
+}
+
+// Read one request from `req->conn`. Return `false` if it is malformed.
+static bool readreq(request *req)
+{
+    u32 len;
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * NUM_REQ_FDS)];
+        struct cmsghdr align;
+    } ctl;
+
+    struct iovec iov = { .iov_base = &len, .iov_len = sizeof(len) };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = ctl.buf,
+        .msg_controllen = sizeof(ctl.buf),
+    };
+
+    ssize_t n;
+    do {
+        n = recvmsg(req->conn, &msg, 0);
+    } while (n < 0 && errno == EINTR);
+
+    struct cmsghdr *cmsg = n > 0 ? CMSG_FIRSTHDR(&msg) : NULL;
+    if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+        return false;
+    }
+
+    // Whatever descriptors arrived are kept, so that they are closed with the
+    // request even if there are too few of them.
+    usize nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    memcpy(req->fds, CMSG_DATA(cmsg), (nfds < NUM_REQ_FDS ? nfds : NUM_REQ_FDS) * sizeof(int));
+    if (nfds != NUM_REQ_FDS) {
+        return false;
+    }
+
+    if ((msg.msg_flags & MSG_CTRUNC)
+        || !recvall(req->conn, (char *)&len + n, sizeof(len) - n)
+        || len == 0
+        || len > MAX_REQUEST_LEN) {
+        return false;
+    }
+
+    req->args = malloc(len);
+    if (req->args == NULL || !recvall(req->conn, req->args, len) || req->args[len - 1] != '\0') {
+        return false;
+    }
+
+    usize argc = 0;
+    for (u32 i = 0; i < len; i++) {
+        argc += req->args[i] == '\0';
+    }
+
+    req->argv = malloc((argc + 1) * sizeof(char *));
+    if (req->argv == NULL) {
+        return false;
+    }
+
+    req->argc = 0;
+    for (char *p = req->args; p < req->args + len; p += strlen(p) + 1) {
+        req->argv[req->argc++] = p;
+    }
+    req->argv[req->argc] = NULL;
+
+    return true;
+}
+
+bool srvaccept(int sock, request *req)
+{
+    while (true) {
+        *req = (request){ .fds = { -1, -1, -1, -1 } };
+        req->conn = accept(sock, NULL, NULL);
+        if (req->conn < 0) {
+            if (errno == ECONNABORTED) {
+                continue;
+            }
+
+            return false;
+        }
+
+        struct timeval timeout = { .tv_sec = REQUEST_TIMEOUT_SEC };
+        if (setsockopt(req->conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0
+            && readreq(req)) {
+            return true;
+        }
+
+        release(req);
+    }
+}
+
+void srvreply(request *req, int exit)
+{
+    u8 status = (u8)exit;
+    sendall(req->conn, &status, sizeof(status));
+    release(req);
+}
+
+bool srvforward(const char *path, int argc, char **argv, int *exit)
+{
+    usize len = 0;
+    for (int i = 0; i < argc; i++) {
+        len += strlen(argv[i]) + 1;
+    }
+
+    if (len > MAX_REQUEST_LEN) {
+        return false;
+    }
+
+    int conn = dial(path);
+    if (conn < 0) {
+        return false;
+    }
+
+    int cwd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    int fds[NUM_REQ_FDS] = {
+        [REQ_STDIN] = STDIN_FILENO,
+        [REQ_STDOUT] = STDOUT_FILENO,
+        [REQ_STDERR] = STDERR_FILENO,
+        [REQ_CWD] = cwd,
+    };
+
+    union {
+        char buf[CMSG_SPACE(sizeof(fds))];
+        struct cmsghdr align;
+    } ctl;
+
+    u32 hdr = (u32)len;
+    struct iovec iov = { .iov_base = &hdr, .iov_len = sizeof(hdr) };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = ctl.buf,
+        .msg_controllen = sizeof(ctl.buf),
+    };
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    // Until the whole request is sent, the server cannot have run it, so any
+    // failure up to then leaves the job to run locally.
+    ssize_t n;
+    do {
+        n = cwd >= 0 ? sendmsg(conn, &msg, MSG_NOSIGNAL) : -1;
+    } while (n < 0 && errno == EINTR);
+
+    bool sent = n > 0 && sendall(conn, (char *)&hdr + n, sizeof(hdr) - n);
+    for (int i = 0; sent && i < argc; i++) {
+        sent = sendall(conn, argv[i], strlen(argv[i]) + 1);
+    }
+
+    if (cwd >= 0) {
+        close(cwd);
+    }
+
+    if (!sent) {
+        close(conn);
+        return false;
+    }
+
+    u8 status;
+    if (!recvall(conn, &status, sizeof(status))) {
+        fprintf(stderr, "metang: lost connection to server on socket “%s”\n", path);
+        status = EXIT_FAILURE;
+    }
+
+    close(conn);
+    *exit = status;
+    return true;
+}
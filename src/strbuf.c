@@ -16,7 +16,9 @@
 
 #include "strbuf.h"
 
+#include <pthread.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "alloc.h"
 
@@ -128,16 +130,21 @@ str strchop(const str *s, char c)
 
 bool strtolong(const str *s, long *l)
 {
+    // Inputs are mapped without a terminator, so no scan may pass `s->len`.
     usize i = 0;
-    for (; isspace(s->buf[i]); i++)
+    for (; i < s->len && isspace(s->buf[i]); i++)
         ;
 
     bool neg = false;
-    if (s->buf[i] == '-') {
+    if (i < s->len && s->buf[i] == '-') {
         neg = true;
         i++;
     }
 
+    if (i == s->len) {
+        return false;
+    }
+
     *l = 0;
     for (; i < s->len; i++) {
         if (s->buf[i] >= '0' && s->buf[i] <= '9') {
@@ -153,6 +160,141 @@ bool strtolong(const str *s, long *l)
     return true;
 }
 
+// Partitions at most this large are finished by insertion sort.
+#define STRSORT_SMALL 16
+
+// Partitions at least this large may be handed to another thread.
+#define STRSORT_PARALLEL_MIN (1 << 16)
+
+typedef struct sortjob {
+    str *v;
+    usize n;
+    usize depth;
+    unsigned spawn;
+} sortjob;
+
+static void mkqsort(str *v, usize n, usize depth, unsigned spawn);
+
+// Bytes past the end of a string sort before every other byte, as the NUL
+// terminator would for `strcmp`.
+static inline int charat(const str *s, usize depth)
+{
+    return depth < s->len ? (unsigned char)s->buf[depth] : -1;
+}
+
+static inline void strswap(str *v, usize i, usize j)
+{
+    str tmp = v[i];
+    v[i] = v[j];
+    v[j] = tmp;
+}
+
+static inline int median3(int a, int b, int c)
+{
+    return a < b ? (b < c ? b : a < c ? c : a)
+                 : (a < c ? a : b < c ? c : b);
+}
+
+// Compare two strings which are known to agree on their first `depth` bytes.
+static int strcmpfrom(const str *s1, const str *s2, usize depth)
+{
+    usize len = s1->len < s2->len ? s1->len : s2->len;
+    int cmp = len > depth ? memcmp(s1->buf + depth, s2->buf + depth, len - depth) : 0;
+    return cmp ? cmp : (s1->len > s2->len) - (s1->len < s2->len);
+}
+
+static void *sortjob_run(void *arg)
+{
+    sortjob *job = arg;
+    mkqsort(job->v, job->n, job->depth, job->spawn);
+    return NULL;
+}
+
+// Multikey quicksort: partition three ways on the byte at `depth`, then sort
+// the lesser and greater partitions on that same byte and the equal partition
+// on the next one. The largest partition is handled by looping rather than
+// recursion, which bounds the stack. While `spawn` is non-zero, the lesser
+// partition of a large range is sorted on a thread of its own.
+static void mkqsort(str *v, usize n, usize depth, unsigned spawn)
+{
+    while (n > STRSORT_SMALL) {
+        int pivot = median3(charat(&v[0], depth), charat(&v[n / 2], depth), charat(&v[n - 1], depth));
+
+        usize lt = 0, i = 0, gt = n;
+        while (i < gt) {
+            int c = charat(&v[i], depth);
+            if (c < pivot) {
+                strswap(v, lt++, i++);
+            } else if (c > pivot) {
+                strswap(v, i, --gt);
+            } else {
+                i++;
+            }
+        }
+
+        // Strings which have ended are all equal, so that partition is done.
+        sortjob parts[3] = {
+            { v,      lt,                      depth,     0 },
+            { v + lt, pivot < 0 ? 0 : gt - lt, depth + 1, 0 },
+            { v + gt, n - gt,                  depth,     0 },
+        };
+
+        if (spawn > 0 && n >= STRSORT_PARALLEL_MIN) {
+            parts[0].spawn = parts[1].spawn = parts[2].spawn = spawn - 1;
+
+            pthread_t thread;
+            bool spawned = pthread_create(&thread, NULL, sortjob_run, &parts[0]) == 0;
+            if (!spawned) {
+                sortjob_run(&parts[0]);
+            }
+
+            sortjob_run(&parts[1]);
+            sortjob_run(&parts[2]);
+            if (spawned) {
+                pthread_join(thread, NULL);
+            }
+
+            return;
+        }
+
+        usize largest = parts[0].n >= parts[1].n ? 0 : 1;
+        largest = parts[2].n > parts[largest].n ? 2 : largest;
+        for (usize p = 0; p < 3; p++) {
+            if (p != largest) {
+                mkqsort(parts[p].v, parts[p].n, parts[p].depth, 0);
+            }
+        }
+
+        v = parts[largest].v;
+        n = parts[largest].n;
+        depth = parts[largest].depth;
+    }
+
+    for (usize i = 1; i < n; i++) {
+        str key = v[i];
+        usize j = i;
+        for (; j > 0 && strcmpfrom(&v[j - 1], &key, depth) > 0; j--) {
+            v[j] = v[j - 1];
+        }
+        v[j] = key;
+    }
+}
+
+void strsort(str *v, usize n, unsigned threads)
+{
+    // Each level of spawning at most doubles the number of busy threads, so
+    // stop once there are about as many as are allowed.
+    unsigned spawn = 0;
+    long ncpu = threads > 0 ? (long)threads : sysconf(_SC_NPROCESSORS_ONLN);
+    ncpu = n >= STRSORT_PARALLEL_MIN ? ncpu : 1;
+    while (ncpu > 1) {
+        spawn++;
+        ncpu /= 2;
+    }
+
+    mkqsort(v, n, 0, spawn);
+}
+
 str strsnake(const str *s, char *buf, const str *extrapunc, bool upper)
 {
     char *p = buf;
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "template.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "outbuf.h"
+
+static bool compile(arena *a, template *t, const char *src, const char *const *slots, usize nslots);
+
+bool tmplcompile(arena *a, tmplset *set)
+{
+    for (usize i = 0; i < set->count; i++) {
+        if (!compile(a, &set->compiled[i], set->srcs[i], set->slots, set->nslots)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void tmplrender(outbuf *out, const template *t, const tmplarg *args)
+{
+    for (usize i = 0; i < t->count; i++) {
+        const tmplseg *seg = &t->segs[i];
+        if (seg->text) {
+            obwrite(out, seg->text, seg->len);
+            continue;
+        }
+
+        const tmplarg *arg = &args[seg->slot];
+        switch (arg->kind) {
+        case TMPL_K_STR:
+            obputs(out, arg->s);
+            break;
+
+        case TMPL_K_TMPL:
+            tmplrender(out, arg->t, args);
+            break;
+
+        case TMPL_K_INT:
+            obint(out, arg->n, 0);
+            break;
+
+        case TMPL_K_UNSET:
+            assert(!"template slot rendered without a value");
+            break;
+        }
+    }
+}
+
+static bool compile(arena *a, template *t, const char *src, const char *const *slots, usize nslots)
+{
+    // Each slot splits a literal span in two, so this bounds the segments.
+    usize cap = 1;
+    for (const char *p = strstr(src, "${"); p; p = strstr(p + 2, "${")) {
+        cap += 2;
+    }
+
+    t->segs = new (a, tmplseg, cap, A_F_ZERO | A_F_EXTEND);
+    t->count = 0;
+
+    const char *p = src;
+    for (const char *open = strstr(p, "${"); open; open = strstr(p, "${")) {
+        const char *name = open + 2;
+        const char *close = strchr(name, '}');
+        if (close == NULL) {
+            fprintf(stderr, "metang: Unterminated slot in template:\n%s\n", src);
+            return false;
+        }
+
+        usize len = close - name;
+        usize slot = 0;
+        while (slot < nslots && (strncmp(slots[slot], name, len) != 0 || slots[slot][len] != '\0')) {
+            slot++;
+        }
+
+        if (slot == nslots) {
+            fprintf(stderr, "metang: Unknown slot “%.*s” in template:\n%s\n", (int)len, name, src);
+            return false;
+        }
+
+        if (open > p) {
+            t->segs[t->count++] = (tmplseg){ .text = p, .len = open - p };
+        }
+
+        t->segs[t->count++] = (tmplseg){ .slot = slot };
+        p = close + 1;
+    }
+
+    if (*p != '\0') {
+        t->segs[t->count++] = (tmplseg){ .text = p, .len = strlen(p) };
+    }
+
+    return true;
+}
@@ -0,0 +1,56 @@
+#!/bin/sh
+
+# Copyright 2025 <lhearachel@proton.me>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Generate from a large input under a limit on address space which holds one
+# arena's reservation, but not one for each worker of a batch. Either way, the
+# output must match that of a run without the limit.
+#
+# Usage: ulimit.sh [METANG]
+
+set -eu
+
+metang=$(cd "$(dirname "${1:-./metang}")" && pwd)/$(basename "${1:-./metang}")
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work"
+
+awk 'BEGIN { for (i = 0; i < 20000; i++) printf "MEMBER_%d\n", i }' > members.txt
+printf 'enum -t Members -i hash -i reverse -o enum.h members.txt\n' > jobs.txt
+head -n 60 members.txt > flags.txt
+printf 'mask -t Flags -T pool -o mask.h flags.txt\n' >> jobs.txt
+
+generate() {
+    mkdir "$1" && cp members.txt flags.txt jobs.txt "$1"
+    (cd "$1" && shift && "$metang" batch "$@" jobs.txt)
+}
+
+generate expected
+(
+    ulimit -v 1572864
+    generate serial
+    generate parallel -j 2
+)
+
+for run in serial parallel; do
+    for h in enum.h mask.h; do
+        if ! cmp -s expected/$h $run/$h; then
+            echo "$run $h differs under ulimit -v" >&2
+            exit 1
+        fi
+    done
+done
+
+echo "✔  alloc - ulimit"
@@ -0,0 +1,50 @@
+#!/bin/sh
+
+# Copyright 2025 <lhearachel@proton.me>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Generate C, with a split source, and Python from one input twice over, with a
+# cache. The second run must hit the cache for both targets: a miss replaces
+# the cache entry by renaming a new file over it, which changes its inode.
+#
+# Usage: split_targets.sh [METANG]
+
+set -eu
+
+metang=$(cd "$(dirname "${1:-./metang}")" && pwd)/$(basename "${1:-./metang}")
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work"
+
+printf 'Bulbasaur\nIvysaur\nVenusaur\n' > pokemon.txt
+generate() {
+    "$metang" enum --cache-dir cache --lang c,py -o pokemon.h -o pokemon.py -s pokemon.c pokemon.txt
+}
+
+generate
+before=$(ls -i cache | sort)
+generate
+after=$(ls -i cache | sort)
+
+if [ "$(ls cache | wc -l)" -ne 3 ]; then
+    echo "expected 3 cache entries, found: $(ls cache)" >&2
+    exit 1
+fi
+
+if [ "$before" != "$after" ]; then
+    printf 'cache entries were rewritten:\n%s\n---\n%s\n' "$before" "$after" >&2
+    exit 1
+fi
+
+echo "✔  cache - split_targets"
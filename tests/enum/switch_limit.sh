@@ -0,0 +1,55 @@
+#!/bin/sh
+
+# Copyright 2025 <lhearachel@proton.me>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Index one member more than a switch trie will hold. The header must fall back
+# to a binary search, and say so on stderr, without changing the options for
+# any other target.
+#
+# Usage: switch_limit.sh [METANG]
+
+set -eu
+
+metang=$(cd "$(dirname "${1:-./metang}")" && pwd)/$(basename "${1:-./metang}")
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work"
+
+awk 'BEGIN { for (i = 0; i <= 4096; i++) printf "MEMBER_%d\n", i }' > members.txt
+"$metang" enum --index switch -o members.h members.txt 2> stderr.txt
+
+expected='metang: warning: 4097 members are too many to index by switch; using bsearch'
+if [ "$(cat stderr.txt)" != "$expected" ]; then
+    printf 'expected warning:\n%s\n---\nfound:\n%s\n' "$expected" "$(cat stderr.txt)" >&2
+    exit 1
+fi
+
+if grep -q 'match__' members.h || ! grep -q -- '--index bsearch' members.h; then
+    echo "header was not indexed by bsearch" >&2
+    exit 1
+fi
+
+# The fallback must not leak into the options given for later targets, which
+# would change the cache key of the Python target between runs.
+for _ in 1 2; do
+    "$metang" enum --index switch --cache-dir cache --lang c,py -o members.h -o members.py members.txt 2>/dev/null
+done
+
+if [ "$(ls cache | wc -l)" -ne 2 ]; then
+    echo "expected 2 cache entries, found: $(ls cache)" >&2
+    exit 1
+fi
+
+echo "✔  enum - switch_limit"
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Run a program test through libmetang rather than the program, and check the
+// output against the test's own. Then check that a listing with an invalid
+// assignment fails to parse.
+//
+// Usage: golden <COMMAND> <TEST FILE>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libmetang.h"
+
+// Split the test file held in `buf` into its sections, in place. Arguments
+// are separated by whitespace, as by tools/runtests.py.
+static bool sections(char *buf, char **args, int *argc, str *input, char **expect)
+{
+    char *in = strstr(buf, "# input\n");
+    char *out = in ? strstr(in, "# output\n") : NULL;
+    if (out == NULL) {
+        return false;
+    }
+
+    *in = '\0';
+    *input = (str){ in + strlen("# input\n"), out - in - strlen("# input\n") };
+    *expect = out + strlen("# output\n");
+
+    *argc = 0;
+    for (char *arg = strtok(buf, " \n"); arg && *argc < 64; arg = strtok(NULL, " \n")) {
+        args[(*argc)++] = arg;
+    }
+
+    return true;
+}
+
+static char *slurp(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    rewind(f);
+
+    char *buf = malloc(len + 1);
+    if (buf && fread(buf, 1, len, f) == (size_t)len) {
+        buf[len] = '\0';
+    } else {
+        free(buf);
+        buf = NULL;
+    }
+
+    fclose(f);
+    return buf;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        fprintf(stderr, "usage: golden <COMMAND> <TEST FILE>\n");
+        return EXIT_FAILURE;
+    }
+
+    enum options_mode mode = strcmp(argv[1], "mask") == 0 ? OPTS_M_MASK : OPTS_M_ENUM;
+    char *buf = slurp(argv[2]);
+    char *args[64];
+    int nargs;
+    str input;
+    char *expect;
+    if (buf == NULL || !sections(buf, args, &nargs, &input, &expect)) {
+        fprintf(stderr, "golden: could not read test “%s”\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    options opts;
+    if (!mtopts(&opts, mode, nargs, args)) {
+        char err[128];
+        optserr(&opts, &(str){ err, sizeof(err) });
+        fprintf(stderr, "golden: %s\n", err);
+        return EXIT_FAILURE;
+    }
+
+    int exit = EXIT_SUCCESS;
+    arena a = arena_new(1 << 16);
+    str header;
+    enumerator *e = mtparse(&a, &input, &opts);
+    if (e == NULL || !mtgenerate(&a, e, &opts, 0, &header, NULL)) {
+        fprintf(stderr, "golden: could not generate “%s”\n", argv[2]);
+        exit = EXIT_FAILURE;
+    } else if (header.len != strlen(expect) || memcmp(header.buf, expect, header.len) != 0) {
+        fprintf(stderr, "golden: output differs from “%s”:\n%s", argv[2], header.buf);
+        exit = EXIT_FAILURE;
+    }
+
+    char bad[] = "Bulbasaur\nIvysaur = x\n";
+    if (mtparse(&a, &(str){ bad, strlen(bad) }, &opts) != NULL) {
+        fprintf(stderr, "golden: parsed an invalid assignment\n");
+        exit = EXIT_FAILURE;
+    }
+
+    arena_free(&a);
+    free(buf);
+    return exit;
+}
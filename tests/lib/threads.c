@@ -0,0 +1,79 @@
+/*
+ * Copyright 2025 <lhearachel@proton.me>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Index a listing large enough for its lookup table to be sorted on several
+// threads, and check that the output matches that of a single thread. The
+// program may not be told how many threads to use, but the library may.
+//
+// Usage: threads
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libmetang.h"
+
+// Enough members to pass the threshold for sorting on more than one thread.
+#define MEMBERS 80000
+
+static bool generate(options *opts, const str *listing, uint32_t threads, arena *a, str *out)
+{
+    opts->threads = threads;
+    enumerator *e = mtparse(a, listing, opts);
+    return e && mtgenerate(a, e, opts, 0, out, NULL);
+}
+
+int main(void)
+{
+    // Members share long prefixes, and are listed out of order.
+    static const char *regions[] = { "ALOLAN", "GALARIAN", "HISUIAN", "PALDEAN" };
+    size_t cap = MEMBERS * 48;
+    char *text = malloc(cap);
+    if (text == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    size_t len = 0;
+    for (unsigned i = 0; i < MEMBERS; i++) {
+        unsigned j = (unsigned)(((unsigned long)i * 7919) % MEMBERS);
+        len += snprintf(text + len, cap - len, "FORM_REGIONAL_VARIANT_%s_%u\n", regions[j % 4], j / 4);
+    }
+
+    char *args[] = { "--index", "bsearch", "-t", "forms" };
+    options opts;
+    if (!mtopts(&opts, OPTS_M_ENUM, 4, args)) {
+        fprintf(stderr, "threads: could not parse options\n");
+        free(text);
+        return EXIT_FAILURE;
+    }
+
+    int exit = EXIT_SUCCESS;
+    str listing = { text, len };
+    str single, several;
+    arena a = arena_new(1 << 20);
+    if (!generate(&opts, &listing, 1, &a, &single) || !generate(&opts, &listing, 4, &a, &several)) {
+        fprintf(stderr, "threads: could not generate the listing\n");
+        exit = EXIT_FAILURE;
+    } else if (single.len != several.len || memcmp(single.buf, several.buf, single.len) != 0) {
+        fprintf(stderr, "threads: output differs between one thread and several\n");
+        exit = EXIT_FAILURE;
+    }
+
+    arena_free(&a);
+    free(text);
+    return exit;
+}
@@ -0,0 +1,60 @@
+#!/bin/sh
+
+# Copyright 2025 <lhearachel@proton.me>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Write an output file over itself, and check that:
+#   - an unchanged output is left alone, keeping its inode and mtime;
+#   - a changed output keeps its mode, whatever the umask;
+#   - an output reached through a symbolic link stays a link.
+#
+# Usage: replace.sh [METANG]
+
+set -eu
+
+metang=$(cd "$(dirname "${1:-./metang}")" && pwd)/$(basename "${1:-./metang}")
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work"
+
+fail() {
+    echo "$1" >&2
+    exit 1
+}
+
+generate() {
+    "$metang" enum -t Pokemon -o "$1" pokemon.txt
+}
+
+printf 'Bulbasaur\nIvysaur\n' > pokemon.txt
+generate pokemon.h
+touch -d '2000-01-01 00:00:00' pokemon.h
+before=$(ls -i pokemon.h)
+generate pokemon.h
+[ "$(ls -i pokemon.h)" = "$before" ] || fail "unchanged output was replaced"
+[ "$(date -r pokemon.h +%Y)" = 2000 ] || fail "unchanged output was rewritten"
+
+chmod 0640 pokemon.h
+printf 'Bulbasaur\nIvysaur\nVenusaur\n' > pokemon.txt
+(umask 077 && generate pokemon.h)
+grep -q VENUSAUR pokemon.h || fail "changed output was not written"
+[ "$(ls -l pokemon.h | cut -c1-10)" = "-rw-r-----" ] || fail "changed output lost its mode: $(ls -l pokemon.h)"
+
+mkdir real
+ln -s real/pokemon.h link.h
+generate link.h
+[ -L link.h ] || fail "symbolic link to output was replaced"
+grep -q VENUSAUR real/pokemon.h || fail "output was not written through the link"
+
+echo "✔  output - replace"
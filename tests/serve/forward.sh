@@ -0,0 +1,76 @@
+#!/bin/sh
+
+# Copyright 2025 <lhearachel@proton.me>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Forward jobs to a server, and check that:
+#   - a forwarded job writes just what a local run would;
+#   - a job reading from a pipe which has yet to end holds up no other job;
+#   - a server refuses to listen over a file which is not a socket.
+#
+# Usage: forward.sh [METANG]
+
+set -eu
+
+metang=$(cd "$(dirname "${1:-./metang}")" && pwd)/$(basename "${1:-./metang}")
+work=$(mktemp -d)
+server=
+trap '[ -z "$server" ] || kill $server 2>/dev/null; rm -rf "$work"' EXIT
+cd "$work"
+
+printf 'Bulbasaur\nIvysaur\nVenusaur\n' > pokemon.txt
+echo 'not a socket' > file
+"$metang" serve --socket file 2>/dev/null &
+refused=$!
+sleep 0.5
+if kill $refused 2>/dev/null || [ "$(cat file 2>/dev/null)" != 'not a socket' ]; then
+    echo "server listened over a regular file" >&2
+    exit 1
+fi
+
+generate() {
+    mkdir -p "$1"
+    (cd "$1" && shift && "$metang" enum -t Pokemon -o pokemon.h "$@")
+}
+
+generate local ../pokemon.txt
+
+"$metang" serve --socket metang.sock &
+server=$!
+for _ in 1 2 3 4 5 6 7 8 9 10; do
+    [ -S metang.sock ] && break
+    sleep 0.2
+done
+
+export METANG_SOCKET="$work/metang.sock"
+
+# The pipe stays open for longer than the next job should take.
+(sleep 3; cat pokemon.txt) | generate piped &
+piped=$!
+sleep 0.5
+
+generate forwarded ../pokemon.txt
+if ! kill -0 $piped 2>/dev/null; then
+    echo "a job on an open pipe held up the server" >&2
+    exit 1
+fi
+
+wait $piped
+sed 's|Source file: stdin|Source file: ../pokemon.txt|' piped/pokemon.h > piped.h
+if ! cmp -s local/pokemon.h forwarded/pokemon.h || ! cmp -s local/pokemon.h piped.h; then
+    echo "output differs from a local run" >&2
+    exit 1
+fi
+
+echo "✔  serve - forward"